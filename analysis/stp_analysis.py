@@ -28,6 +28,10 @@ def parse_dir(dir_path: str | PathLike[str]):
     dfs = [parse_file(file_path) for file_path in dir_path.rglob('*') if file_path.suffix in ['.out', '.txt', '.log']]
     df = pd.concat(dfs, ignore_index=True)
 
+    # Runs stopped by a resource limit have no solution to compare
+    if 'status' in df:
+        df = df[df['status'] == 'solved'].copy()
+
     # Convert types
     df['id'] = df['id'].astype(int)
     df['solution'] = df['solution'].astype(float)
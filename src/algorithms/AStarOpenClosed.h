@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <unordered_map>
 #include <vector>
+#include "FlatHashTable.h"
 
 struct AHash64 {
 	size_t operator()(const uint64_t &x) const
@@ -111,8 +112,7 @@ private:
 
 	std::vector<uint64_t> theHeap;
 	// storing the element id; looking up with...hash?
-	// TODO: replace this with C++11 data structures
-	typedef std::unordered_map<uint64_t, uint64_t, AHash64> IndexTable;
+	typedef FlatHashTable<uint64_t> IndexTable;
 	IndexTable table;
 	std::vector<dataStructure> elements;
 };
@@ -129,7 +129,8 @@ AStarOpenClosed<state, CmpKey, dataStructure>::~AStarOpenClosed()
 }
 
 /**
- * Remove all objects from queue.
+ * Remove all objects from queue. The element list, the heap and the slots of the index table keep their
+ * capacity, so a queue reused across searches does not have to grow again from scratch.
  */
 template<typename state, typename CmpKey, class dataStructure>
 void AStarOpenClosed<state, CmpKey, dataStructure>::Reset(int)
@@ -148,12 +149,12 @@ uint64_t AStarOpenClosed<state, CmpKey, dataStructure>::AddOpenNode(const state
 	//size_t hash = hashFcn(val);
 	// Change to behavior: if we have a duplicate state instead throwing and error,
 	// we update if the path is shorter, otherwise return the old state
-	auto i = table.find(hash);
-	if (i != table.end())
+	const uint64_t *i = table.Find(hash);
+	if (i != nullptr)
 	{
 		//return -1; // TODO: find correct id and return
 		//assert(false);
-		uint64_t index = i->second;
+		uint64_t index = *i;
 		if (fless(g, elements[index].g))
 		{
 			elements[index].parentID = parent;
@@ -166,7 +167,7 @@ uint64_t AStarOpenClosed<state, CmpKey, dataStructure>::AddOpenNode(const state
 	elements.push_back(dataStructure(val, f, g, h, parent, theHeap.size(), kOpenList));
 	if (parent == kTAStarNoNode)
 		elements.back().parentID = elements.size()-1;
-	table[hash] = elements.size()-1; // hashing to element list location
+	table.Insert(hash) = elements.size()-1; // hashing to element list location
 	theHeap.push_back(elements.size()-1); // adding element id to back of heap
 	HeapifyUp(theHeap.size()-1); // heapify from back of the heap
 	return elements.size()-1;
@@ -180,12 +181,12 @@ uint64_t AStarOpenClosed<state, CmpKey, dataStructure>::AddOpenNode(const state
 {
 	// Change to behavior: if we have a duplicate state instead throwing and error,
 	// we update if the path is shorter, otherwise return the old state
-	auto i = table.find(hash);
-	if (i != table.end())
+	const uint64_t *i = table.Find(hash);
+	if (i != nullptr)
 	{
 		//return -1; // TODO: find correct id and return
 		//assert(false);
-		uint64_t index = i->second;
+		uint64_t index = *i;
 		if (fless(g, elements[index].g))
 		{
 			elements[index].parentID = parent;
@@ -197,7 +198,7 @@ uint64_t AStarOpenClosed<state, CmpKey, dataStructure>::AddOpenNode(const state
 	elements.push_back(dataStructure(val, g, h, parent, theHeap.size(), kOpenList));
 	if (parent == kTAStarNoNode)
 		elements.back().parentID = elements.size()-1;
-	table[hash] = elements.size()-1; // hashing to element list location
+	table.Insert(hash) = elements.size()-1; // hashing to element list location
 	theHeap.push_back(elements.size()-1); // adding element id to back of heap
 	HeapifyUp(theHeap.size()-1); // heapify from back of the heap
 	return elements.size()-1;
@@ -210,11 +211,11 @@ template<typename state, typename CmpKey, class dataStructure>
 uint64_t AStarOpenClosed<state, CmpKey, dataStructure>::AddClosedNode(state &val, uint64_t hash, double f, double g, double h, uint64_t parent)
 {
 	// should do lookup here...
-	assert(table.find(hash) == table.end());
+	assert(table.Find(hash) == nullptr);
 	elements.push_back(dataStructure(val, f, g, h, parent, 0, kClosedList));
 	if (parent == kTAStarNoNode)
 		elements.back().parentID = elements.size()-1;
-	table[hash] = elements.size()-1; // hashing to element list location
+	table.Insert(hash) = elements.size()-1; // hashing to element list location
 	return elements.size()-1;
 }
 
@@ -222,11 +223,11 @@ template<typename state, typename CmpKey, class dataStructure>
 uint64_t AStarOpenClosed<state, CmpKey, dataStructure>::AddClosedNode(state &val, uint64_t hash, double g, double h, uint64_t parent)
 {
 	// should do lookup here...
-	assert(table.find(hash) == table.end());
+	assert(table.Find(hash) == nullptr);
 	elements.push_back(dataStructure(val, g, h, parent, 0, kClosedList));
 	if (parent == kTAStarNoNode)
 		elements.back().parentID = elements.size()-1;
-	table[hash] = elements.size()-1; // hashing to element list location
+	table.Insert(hash) = elements.size()-1; // hashing to element list location
 	return elements.size()-1;
 }
 
@@ -236,10 +237,10 @@ uint64_t AStarOpenClosed<state, CmpKey, dataStructure>::AddClosedNode(state &val
 template<typename state, typename CmpKey, class dataStructure>
 void AStarOpenClosed<state, CmpKey, dataStructure>::Remove(uint64_t hash)
 {
-	uint64_t index = table[hash];
+	uint64_t index = table.Insert(hash);
 	uint64_t openLoc = elements[index].openLocation;
 	uint64_t swappedItem = theHeap.back();
-	table.erase(table.find(hash));
+	table.Erase(hash);
 	theHeap[openLoc] = theHeap.back();
 	theHeap.pop_back();
 	elements[swappedItem].openLocation = openLoc;
@@ -262,11 +263,10 @@ void AStarOpenClosed<state, CmpKey, dataStructure>::KeyChanged(uint64_t val)
 template<typename state, typename CmpKey, class dataStructure>
 dataLocation AStarOpenClosed<state, CmpKey, dataStructure>::Lookup(uint64_t hashKey, uint64_t &objKey) const
 {
-	typename IndexTable::const_iterator it;
-	it = table.find(hashKey);
-	if (it != table.end())
+	const uint64_t *it = table.Find(hashKey);
+	if (it != nullptr)
 	{
-		objKey = (*it).second;
+		objKey = *it;
 		return elements[objKey].where;
 	}
 	return kNotFound;
@@ -0,0 +1,244 @@
+/*
+ *  BDBucketOpenClosed.h
+ *
+ *  A bucketed open/closed list for BAE*, which can replace the binary heap of BDSharedOpenClosed through the
+ *  priorityQueue template parameter of BAE.
+ */
+
+#ifndef BDBUCKETOPENCLOSED_H
+#define BDBUCKETOPENCLOSED_H
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "AStarOpenClosed.h"
+#include "BDSharedOpenClosed.h"
+#include "FPUtil.h"
+
+/**
+ * The open/closed list of one direction of BAE*, ordered like BAECompare: low b-value (stored in h) first, and high g
+ * among equal b-values. Open nodes are kept in buckets indexed by round(b / gcd), each split into sub-buckets indexed
+ * by round(g / gcd), so adding, removing and moving a node between buckets are O(1); finding the next non-empty bucket
+ * is amortized over the search.
+ *
+ * The order is exact only if every b-value and g-value is a multiple of the gcd. This holds in all three domains of the
+ * driver: STP and pancake have unit edges, and the grids have diagonals of cost 1.5 with a gcd of 0.5. Nodes with the
+ * same b and g are expanded last-in first-out, so ties may be broken differently than by the heap.
+ * States are indexed in a BDSharedIndex (or the given index type) shared with the list of the opposite direction, as in
+ * BDSharedOpenClosed.
+ */
+template<typename state, class dataStructure = AStarOpenClosedData<state>, class indexType = BDSharedIndex>
+class BDBucketOpenClosed {
+public:
+    // The type of the costs in the records, double unless the records hold another one
+    typedef decltype(dataStructure::g) cost;
+    // The type of the index the search owns and shares between its two lists
+    typedef indexType index;
+
+    BDBucketOpenClosed() : sharedIndex(nullptr), side(0), gcd(1.0), baseKey(0), minBucket(0), openSize(0) {}
+
+    BDBucketOpenClosed(const BDBucketOpenClosed &) = delete;
+
+    BDBucketOpenClosed &operator=(const BDBucketOpenClosed &) = delete;
+
+    /**
+     * Attaches the list to the index shared with the opposite direction
+     * @param side_ 0 for the forward list, 1 for the backward list
+     */
+    void SetIndex(indexType *index_, int side_) {
+        sharedIndex = index_;
+        side = side_;
+    }
+
+    /**
+     * @param gcd_ Greatest common denominator between all edges, which is the width of a bucket
+     */
+    void SetGranularity(double gcd_) { gcd = gcd_; }
+
+    /**
+     * Remove all objects from the list. The buckets keep their capacity for the next search, and the shared index is
+     * reset by its owner.
+     */
+    void Reset(int = 0) {
+        elements.clear();
+        keys.clear();
+        for (auto &bucket: buckets) {
+            for (auto &cell: bucket.cells)
+                cell.clear();
+            bucket.count = 0;
+            bucket.top = 0;
+        }
+        minBucket = buckets.size();
+        openSize = 0;
+    }
+
+    uint64_t AddOpenNode(const state &val, uint64_t hash, cost g, cost h, uint64_t parent = kTAStarNoNode) {
+        return AddOpenNode(val, sharedIndex->Insert(hash), g, h, parent);
+    }
+
+    /**
+     * Add a state which is not yet in this direction into the open list
+     * @param slot The slot of the state in the shared index
+     */
+    uint64_t AddOpenNode(const state &val, BDSharedSlot &slot, cost g, cost h, uint64_t parent = kTAStarNoNode) {
+        assert(slot.id[side] == kTAStarNoNode);
+        uint64_t objKey = elements.size();
+        elements.push_back(dataStructure(val, g, h, parent, 0, kOpenList));
+        keys.push_back(Key());
+        if (parent == kTAStarNoNode)
+            elements.back().parentID = objKey;
+        slot.id[side] = objKey;
+        Push(objKey);
+        return objKey;
+    }
+
+    /**
+     * Returns location of object as well as object key.
+     */
+    dataLocation Lookup(uint64_t hashKey, uint64_t &objKey) const { return Lookup(sharedIndex->Find(hashKey), objKey); }
+
+    /**
+     * Same as above, for a slot already found in the shared index (or nullptr)
+     */
+    dataLocation Lookup(const BDSharedSlot *slot, uint64_t &objKey) const {
+        if (slot == nullptr || slot->id[side] == kTAStarNoNode)
+            return kNotFound;
+        objKey = slot->id[side];
+        return elements[objKey].where;
+    }
+
+    inline dataStructure &Lookup(uint64_t objKey) { return elements[objKey]; }
+
+    inline const dataStructure &Lookat(uint64_t objKey) const { return elements[objKey]; }
+
+    /**
+     * Indicate that the key for a particular object has changed, which moves it to the bucket of its new b and g.
+     */
+    void KeyChanged(uint64_t objKey) {
+        assert(elements[objKey].where == kOpenList);
+        Pop(objKey);
+        Push(objKey);
+    }
+
+    /**
+     * Peek at the next item to be expanded.
+     */
+    uint64_t Peek() const {
+        assert(OpenSize() != 0);
+        const Bucket &bucket = buckets[minBucket];
+        return bucket.cells[bucket.top].back();
+    }
+
+    /**
+     * Move the best item to the closed list and return key.
+     */
+    uint64_t Close() {
+        uint64_t ans = Peek();
+        Pop(ans);
+        elements[ans].where = kClosedList;
+        return ans;
+    }
+
+    /**
+     * Move item off the closed list and back onto the open list.
+     */
+    void Reopen(uint64_t objKey) {
+        assert(elements[objKey].where == kClosedList);
+        elements[objKey].reopened = true;
+        elements[objKey].where = kOpenList;
+        Push(objKey);
+    }
+
+    size_t OpenSize() const { return openSize; }
+
+    size_t ClosedSize() const { return size() - OpenSize(); }
+
+    size_t size() const { return elements.size(); }
+
+    bool empty() const { return openSize == 0; }
+
+private:
+    /**
+     * The bucket and sub-bucket a node was put in, kept apart from the node so they are known after its b and g
+     * have changed
+     */
+    struct Key {
+        size_t bucket;
+        size_t cell;
+    };
+
+    struct Bucket {
+        std::vector<std::vector<uint64_t>> cells; // Indexed by round(g / gcd)
+        size_t count = 0; // Number of nodes in all the cells
+        size_t top = 0; // Highest non-empty cell, if count > 0
+    };
+
+    int64_t ToKey(double value) const { return std::llround(value / gcd); }
+
+    void Push(uint64_t objKey) {
+        const dataStructure &data = elements[objKey];
+        assert(fequal(ToKey(data.h) * gcd, data.h) && fequal(ToKey(data.g) * gcd, data.g));
+        int64_t key = ToKey(data.h);
+        if (buckets.empty())
+            baseKey = key;
+        if (key < baseKey) {
+            // Rare, as b never decreases below the b of the roots with a consistent heuristic
+            size_t shift = static_cast<size_t>(baseKey - key);
+            buckets.insert(buckets.begin(), shift, Bucket());
+            for (auto &k: keys)
+                k.bucket += shift;
+            minBucket += shift;
+            baseKey = key;
+        }
+        size_t b = static_cast<size_t>(key - baseKey);
+        if (b >= buckets.size())
+            buckets.resize(b + 1);
+        int64_t gKey = ToKey(data.g);
+        size_t c = gKey > 0 ? static_cast<size_t>(gKey) : 0;
+        Bucket &bucket = buckets[b];
+        if (c >= bucket.cells.size())
+            bucket.cells.resize(c + 1);
+        if (bucket.count == 0 || c > bucket.top)
+            bucket.top = c;
+        bucket.count++;
+        elements[objKey].openLocation = bucket.cells[c].size();
+        bucket.cells[c].push_back(objKey);
+        keys[objKey] = Key{b, c};
+        if (b < minBucket || openSize == 0)
+            minBucket = b;
+        openSize++;
+    }
+
+    void Pop(uint64_t objKey) {
+        Key key = keys[objKey];
+        Bucket &bucket = buckets[key.bucket];
+        std::vector<uint64_t> &cell = bucket.cells[key.cell];
+        uint64_t loc = elements[objKey].openLocation;
+        cell[loc] = cell.back();
+        elements[cell[loc]].openLocation = loc;
+        cell.pop_back();
+        bucket.count--;
+        openSize--;
+        if (bucket.count > 0) {
+            while (bucket.cells[bucket.top].empty())
+                bucket.top--;
+        } else if (key.bucket == minBucket) {
+            while (minBucket < buckets.size() && buckets[minBucket].count == 0)
+                minBucket++;
+        }
+    }
+
+    indexType *sharedIndex;
+    int side; // Which of the ids of a slot belongs to this list
+    double gcd;
+    int64_t baseKey; // round(b / gcd) of buckets[0]
+    size_t minBucket; // Lowest non-empty bucket, if the open list is not empty
+    size_t openSize;
+    std::vector<Bucket> buckets;
+    std::vector<Key> keys; // Parallel to elements
+    std::vector<dataStructure> elements;
+};
+
+#endif
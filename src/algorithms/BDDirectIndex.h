@@ -0,0 +1,109 @@
+/*
+ *  BDDirectIndex.h
+ *
+ *  An index of the states seen by a bidirectional search for domains whose state hash is a perfect hash, e.g., the
+ *  cell index of grids. It replaces BDSharedIndex through the index template parameter of BDSharedOpenClosed.
+ */
+
+#ifndef BDDIRECTINDEX_H
+#define BDDIRECTINDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+#include "BDSharedOpenClosed.h"
+#include "FlatHashTable.h"
+
+/**
+ * The slot of a state is addressed by its hash, so finding it needs neither hashing nor probing. A packed bit per
+ * state tells whether it has a slot, and the slots are kept in pages allocated when a state of the page is first
+ * inserted, so the memory grows with the part of the state space the search touches rather than with all of it.
+ *
+ * The hashes must be below the max hash of the environment given to Reset. If it reports no max hash, or one too large
+ * to address directly (as the permutation ranks of the 16-pancake), the index falls back to a FlatHashTable.
+ */
+class BDDirectIndex {
+public:
+    BDDirectIndex() : maxHash(0), direct(false), count(0) {}
+
+    /**
+     * Removes all slots. The pages keep their memory for the next search.
+     * @param maxHash_ Bound on the hashes of the states of the next search, 0 if unknown
+     */
+    void Reset(uint64_t maxHash_ = 0) {
+        count = 0;
+        table.clear();
+        direct = maxHash_ != 0 && maxHash_ <= kMaxDirectHash;
+        if (!direct)
+            return;
+        if (maxHash_ != maxHash) {
+            maxHash = maxHash_;
+            pages.clear();
+            pages.resize((maxHash + kPageSize - 1) / kPageSize);
+            used.resize((maxHash + 63) / 64);
+        }
+        std::fill(used.begin(), used.end(), 0);
+    }
+
+    /**
+     * @return The slot of the state with the given hash, nullptr if no direction has seen it
+     */
+    BDSharedSlot *Find(uint64_t hash) {
+        if (!direct)
+            return table.Find(hash);
+        return Used(hash) ? &Slot(hash) : nullptr;
+    }
+
+    const BDSharedSlot *Find(uint64_t hash) const {
+        if (!direct)
+            return table.Find(hash);
+        return Used(hash) ? &pages[hash / kPageSize][hash % kPageSize] : nullptr;
+    }
+
+    /**
+     * @return The slot of the state with the given hash, created empty if needed. Unlike BDSharedIndex, slots are never
+     * moved once the index addresses them directly.
+     */
+    BDSharedSlot &Insert(uint64_t hash) {
+        if (!direct)
+            return table.Insert(hash);
+        std::unique_ptr<BDSharedSlot[]> &page = pages[hash / kPageSize];
+        if (!page)
+            page.reset(new BDSharedSlot[kPageSize]);
+        BDSharedSlot &slot = page[hash % kPageSize];
+        if (!Used(hash)) {
+            used[hash / 64] |= uint64_t(1) << (hash % 64);
+            slot = BDSharedSlot();
+            count++;
+        }
+        return slot;
+    }
+
+    void Prefetch(uint64_t hash) const {
+        if (!direct)
+            table.Prefetch(hash);
+    }
+
+    size_t size() const { return direct ? count : table.size(); }
+
+private:
+    // A page holds the slots of 4096 consecutive hashes (64KB)
+    static const uint64_t kPageSize = 4096;
+    // Up to 2^30 hashes are addressed directly, which takes 128MB of bits and 2MB of page pointers
+    static const uint64_t kMaxDirectHash = uint64_t(1) << 30;
+
+    bool Used(uint64_t hash) const { return (used[hash / 64] >> (hash % 64)) & 1; }
+
+    BDSharedSlot &Slot(uint64_t hash) { return pages[hash / kPageSize][hash % kPageSize]; }
+
+    uint64_t maxHash;
+    bool direct; // Whether the hashes of the current search are addressed directly
+    size_t count;
+    std::vector<uint64_t> used; // A bit per hash, set if the state has a slot
+    std::vector<std::unique_ptr<BDSharedSlot[]>> pages;
+    FlatHashTable<BDSharedSlot> table; // Used instead when the hashes cannot be addressed directly
+};
+
+#endif //BDDIRECTINDEX_H
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <unordered_map>
 #include "AStarOpenClosed.h"
+#include "FlatHashTable.h"
 
 //#define ADMISSIBLE
 //struct AHash64 {
@@ -124,7 +125,7 @@ private:
 	//std::vector<uint64_t> waitingQueue;
 
 	// storing the element id; looking up with hash
-	std::unordered_map<uint64_t, size_t> table;
+	FlatHashTable<size_t> table;
 	//all the elements, open or closed
 	std::vector<dataStructure> elements;
 };
@@ -183,7 +184,7 @@ template<typename state, typename CmpKey0, typename CmpKey1,   class dataStructu
 uint64_t BDOpenClosed<state, CmpKey0, CmpKey1,   dataStructure>::AddOpenNode(const state &val, uint64_t hash, double g, double h, uint64_t parent, stateLocation whichQueue)
 {
 	// should do lookup here...
-	if (table.find(hash) != table.end())
+	if (table.Find(hash) != nullptr)
 	{
 		//return -1; // TODO: find correct id and return
 		assert(false);
@@ -200,7 +201,7 @@ uint64_t BDOpenClosed<state, CmpKey0, CmpKey1,   dataStructure>::AddOpenNode(con
 
 	if (parent == kTBDNoNode)
 		elements.back().parentID = elements.size()-1;
-	table[hash] = elements.size()-1; // hashing to element list location
+	table.Insert(hash) = elements.size()-1; // hashing to element list location
 
 	priorityQueues[whichQueue].push_back(elements.size() - 1);
 	HeapifyUp(priorityQueues[whichQueue].size() - 1,whichQueue);
@@ -215,11 +216,11 @@ template<typename state, typename CmpKey0, typename CmpKey1,   class dataStructu
 uint64_t BDOpenClosed<state, CmpKey0, CmpKey1,   dataStructure>::AddClosedNode(state &val, uint64_t hash, double g, double h, uint64_t parent)
 {
 	// should do lookup here...
-	assert(table.find(hash) == table.end());
+	assert(table.Find(hash) == nullptr);
 	elements.push_back(dataStructure(val, g, h, parent, 0, kClosed));
 	if (parent == kTBDNoNode)
 		elements.back().parentID = elements.size()-1;
-	table[hash] = elements.size()-1; // hashing to element list location
+	table.Insert(hash) = elements.size()-1; // hashing to element list location
 	return elements.size()-1;
 }
 
@@ -281,11 +282,11 @@ void BDOpenClosed<state, CmpKey0, CmpKey1, dataStructure>::Remove(uint64_t val)
 template<typename state, typename CmpKey0, typename CmpKey1,   class dataStructure>
 stateLocation BDOpenClosed<state, CmpKey0, CmpKey1,   dataStructure>::Lookup(uint64_t hashKey, uint64_t &objKey) const
 {
-	auto it = table.find(hashKey);
-	if (it == table.end())
+	const size_t *it = table.Find(hashKey);
+	if (it == nullptr)
 		return kUnseen;
 	
-	objKey = it->second;
+	objKey = *it;
 	return elements[objKey].where;
 }
 
@@ -0,0 +1,223 @@
+/*
+ *  BDPublishedIndex.h
+ *
+ *  The index of the states of one direction of a parallel bidirectional search. It is written only by the thread of
+ *  its direction, which indexes its open/closed list in it, and read without locks by the other threads, which find
+ *  there the g-cost of a state in that direction and whether it was closed.
+ */
+
+#ifndef BDPUBLISHEDINDEX_H
+#define BDPUBLISHEDINDEX_H
+
+#include <atomic>
+#include <cfloat>
+#include <cstddef>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+#include "BDSharedOpenClosed.h"
+
+/**
+ * The slot of a state in the index of one direction. The ids are only used by the thread owning the index, the g-cost
+ * (DBL_MAX until it is published) and the closed flag are also read by the other threads.
+ */
+struct BDPublishedSlot : public BDSharedSlot {
+    BDPublishedSlot() : g(DBL_MAX), closed(false) {}
+
+    std::atomic<double> g;
+    std::atomic<bool> closed;
+};
+
+/**
+ * Slots are placed by linear probing and never move within an array, so a reader probing the array sees every entry
+ * either complete or not at all: the owner fills a slot before storing its key. When the array fills up, the owner
+ * copies the entries into one twice as large and publishes it. A reader may still be probing the old array, so it is
+ * kept until the next Reset, when no thread searches.
+ *
+ * The keys and the g-costs are stored and loaded sequentially consistent. When two threads publish the g-cost of the
+ * same state in their own index and then read it in the other one, at least one of them sees the g-cost of the other,
+ * so the meeting of the directions is never missed.
+ *
+ * The functions of the owner (Find, Insert, Prefetch) implement the index of BDSharedOpenClosed; the other threads
+ * only call the Shared functions.
+ */
+class BDPublishedIndex {
+public:
+    BDPublishedIndex() : published(nullptr), count(0) {}
+
+    BDPublishedIndex(const BDPublishedIndex &) = delete;
+
+    BDPublishedIndex &operator=(const BDPublishedIndex &) = delete;
+
+    /**
+     * Removes all slots. The array keeps its capacity for the next search. Must not be called while other threads
+     * use the index.
+     * The bound on the hashes of the next search, taken by indexes addressing states by hash, is not needed here.
+     */
+    void Reset(uint64_t = 0) {
+        retired.clear();
+        if (count == 0)
+            return;
+        for (size_t i = 0; i <= array->mask; i++)
+            array->entries[i].key.store(kEmpty, std::memory_order_relaxed);
+        count = 0;
+    }
+
+    /**
+     * @return The slot of the state with the given hash, nullptr if it is not in the index
+     */
+    BDPublishedSlot *Find(uint64_t hash) {
+        if (count == 0)
+            return nullptr;
+        for (size_t i = Mix(hash) & array->mask;; i = (i + 1) & array->mask) {
+            uint64_t key = array->entries[i].key.load(std::memory_order_relaxed);
+            if (key == hash)
+                return &array->entries[i].slot;
+            if (key == kEmpty)
+                return nullptr;
+        }
+    }
+
+    const BDPublishedSlot *Find(uint64_t hash) const { return const_cast<BDPublishedIndex *>(this)->Find(hash); }
+
+    /**
+     * @return The slot of the state with the given hash, created empty if needed. Inserting may move the slots, so
+     * the reference, like the pointers returned by Find, stays valid only until the next Insert.
+     */
+    BDPublishedSlot &Insert(uint64_t hash) {
+        BDPublishedSlot *slot = Find(hash);
+        if (slot != nullptr)
+            return *slot;
+        if (array == nullptr || (count + 1) * kMaxLoadDenominator > (array->mask + 1) * kMaxLoadNumerator)
+            Grow();
+        count++;
+        Entry &entry = array->entries[Place(*array, hash)];
+        entry.slot.id[0] = entry.slot.id[1] = kTAStarNoNode;
+        entry.slot.g.store(DBL_MAX, std::memory_order_relaxed);
+        entry.slot.closed.store(false, std::memory_order_relaxed);
+        entry.key.store(hash);
+        return entry.slot;
+    }
+
+    void Prefetch(uint64_t hash) const {
+#if defined(__GNUC__) || defined(__clang__)
+        if (array != nullptr)
+            __builtin_prefetch(&array->entries[Mix(hash) & array->mask]);
+#endif
+    }
+
+    size_t size() const { return count; }
+
+    /**
+     * Called by any thread
+     * @return The g-cost published for the state with the given hash, DBL_MAX if there is none
+     */
+    double SharedG(uint64_t hash) const {
+        const BDPublishedSlot *slot = FindShared(hash);
+        return slot == nullptr ? DBL_MAX : slot->g.load();
+    }
+
+    /**
+     * Called by any thread
+     * @return Whether the state with the given hash was closed
+     */
+    bool SharedClosed(uint64_t hash) const {
+        const BDPublishedSlot *slot = FindShared(hash);
+        return slot != nullptr && slot->closed.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Called by any thread, prefetches the slot of a state whose g-cost will be read soon
+     */
+    void PrefetchShared(uint64_t hash) const {
+#if defined(__GNUC__) || defined(__clang__)
+        const Array *shared = published.load(std::memory_order_relaxed);
+        if (shared != nullptr)
+            __builtin_prefetch(&shared->entries[Mix(hash) & shared->mask]);
+#endif
+    }
+
+private:
+    static const uint64_t kEmpty = ~uint64_t(0); // No state has this hash
+    static const size_t kInitialSize = 1024;
+    // Linear probing without reordering needs a lower load than the robin-hood probing of FlatHashTable
+    static const size_t kMaxLoadNumerator = 1;
+    static const size_t kMaxLoadDenominator = 2;
+
+    struct Entry {
+        Entry() : key(kEmpty) {}
+
+        std::atomic<uint64_t> key;
+        BDPublishedSlot slot;
+    };
+
+    struct Array {
+        explicit Array(size_t size) : mask(size - 1), entries(new Entry[size]) {}
+
+        size_t mask;
+        std::unique_ptr<Entry[]> entries;
+    };
+
+    /**
+     * The finalizer of MurmurHash3, as in FlatHashTable, since the low bits of state hashes are far from uniform
+     */
+    static uint64_t Mix(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    /**
+     * @return The first empty entry of the probe sequence of the given hash
+     */
+    static size_t Place(const Array &to, uint64_t hash) {
+        size_t i = Mix(hash) & to.mask;
+        while (to.entries[i].key.load(std::memory_order_relaxed) != kEmpty)
+            i = (i + 1) & to.mask;
+        return i;
+    }
+
+    const BDPublishedSlot *FindShared(uint64_t hash) const {
+        const Array *shared = published.load();
+        if (shared == nullptr)
+            return nullptr;
+        for (size_t i = Mix(hash) & shared->mask;; i = (i + 1) & shared->mask) {
+            uint64_t key = shared->entries[i].key.load();
+            if (key == hash)
+                return &shared->entries[i].slot;
+            if (key == kEmpty)
+                return nullptr;
+        }
+    }
+
+    void Grow() {
+        std::unique_ptr<Array> grown(new Array(array == nullptr ? kInitialSize : (array->mask + 1) * 2));
+        if (array != nullptr) {
+            for (size_t i = 0; i <= array->mask; i++) {
+                const Entry &from = array->entries[i];
+                uint64_t key = from.key.load(std::memory_order_relaxed);
+                if (key == kEmpty)
+                    continue;
+                Entry &to = grown->entries[Place(*grown, key)];
+                to.slot.id[0] = from.slot.id[0];
+                to.slot.id[1] = from.slot.id[1];
+                to.slot.g.store(from.slot.g.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.slot.closed.store(from.slot.closed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                to.key.store(key, std::memory_order_relaxed);
+            }
+            retired.push_back(std::move(array));
+        }
+        array = std::move(grown);
+        published.store(array.get());
+    }
+
+    std::unique_ptr<Array> array; // Written by the owner
+    std::vector<std::unique_ptr<Array>> retired; // Replaced arrays, which other threads may still be probing
+    std::atomic<const Array *> published; // The array the other threads probe
+    size_t count;
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ *  BDSharedOpenClosed.h
+ *
+ *  Open/closed lists of the two directions of a bidirectional search, sharing a single hash index. The index holds
+ *  one slot per state with the id of its record in each direction, so a single probe finds both records, and with
+ *  them both g-values and both locations.
+ */
+
+#ifndef BDSHAREDOPENCLOSED_H
+#define BDSHAREDOPENCLOSED_H
+
+#include <cassert>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include "AStarOpenClosed.h"
+#include "FlatHashTable.h"
+
+/**
+ * The ids of the records of a single state, kTAStarNoNode for a direction which has not seen it
+ */
+struct BDSharedSlot {
+    BDSharedSlot() : id{kTAStarNoNode, kTAStarNoNode} {}
+
+    uint64_t id[2];
+};
+
+/**
+ * Hash index of the states seen in both directions. It is owned by the search, which attaches its forward (side 0)
+ * and backward (side 1) lists to it and resets it at the start of every search.
+ */
+class BDSharedIndex {
+public:
+    /**
+     * Removes all slots. The table keeps its capacity for the next search.
+     * The bound on the hashes of the next search, taken by indexes addressing states by hash, is not needed here.
+     */
+    void Reset(uint64_t = 0) { table.clear(); }
+
+    /**
+     * @return The slot of the state with the given hash, nullptr if no direction has seen it
+     */
+    BDSharedSlot *Find(uint64_t hash) { return table.Find(hash); }
+
+    const BDSharedSlot *Find(uint64_t hash) const { return table.Find(hash); }
+
+    /**
+     * @return The slot of the state with the given hash, created empty if needed. Inserting may move the slots, so
+     * the reference, like the pointers returned by Find, stays valid only until the next Insert.
+     */
+    BDSharedSlot &Insert(uint64_t hash) { return table.Insert(hash); }
+
+    /**
+     * Prefetches the slot of the state with the given hash, to be looked up soon
+     */
+    void Prefetch(uint64_t hash) const { table.Prefetch(hash); }
+
+    size_t size() const { return table.size(); }
+
+private:
+    FlatHashTable<BDSharedSlot> table;
+};
+
+/**
+ * The open/closed list of one direction. It behaves like AStarOpenClosed (same heap, same tie-breaking), except that
+ * states are indexed in the shared index instead of a table of its own. The slot-based functions let a search that
+ * already holds the slot of a state skip hashing it again.
+ * The index is BDSharedIndex, or any class with the same functions, such as BDDirectIndex.
+ */
+template<typename state, typename CmpKey, class dataStructure = AStarOpenClosedData<state>,
+        class indexType = BDSharedIndex>
+class BDSharedOpenClosed {
+public:
+    // The type of the costs in the records, double unless the records hold another one
+    typedef decltype(dataStructure::g) cost;
+    // The type of the index the search owns and shares between its two lists
+    typedef indexType index;
+
+    BDSharedOpenClosed() : sharedIndex(nullptr), side(0) {}
+
+    BDSharedOpenClosed(const BDSharedOpenClosed &) = delete;
+
+    BDSharedOpenClosed &operator=(const BDSharedOpenClosed &) = delete;
+
+    /**
+     * Attaches the list to the index shared with the opposite direction
+     * @param side_ 0 for the forward list, 1 for the backward list
+     */
+    void SetIndex(indexType *index_, int side_) {
+        sharedIndex = index_;
+        side = side_;
+    }
+
+    /**
+     * The heap orders the exact costs, so it does not need the granularity of the costs
+     */
+    void SetGranularity(double) {}
+
+    /**
+     * Remove all objects from the list. The shared index is reset by its owner.
+     */
+    void Reset(int = 0) {
+        elements.clear();
+        theHeap.resize(0);
+    }
+
+    uint64_t AddOpenNode(const state &val, uint64_t hash, cost g, cost h, uint64_t parent = kTAStarNoNode) {
+        return AddOpenNode(val, sharedIndex->Insert(hash), g, h, parent);
+    }
+
+    /**
+     * Add a state which is not yet in this direction into the open list
+     * @param slot The slot of the state in the shared index
+     */
+    uint64_t AddOpenNode(const state &val, BDSharedSlot &slot, cost g, cost h, uint64_t parent = kTAStarNoNode) {
+        assert(slot.id[side] == kTAStarNoNode);
+        elements.push_back(dataStructure(val, g, h, parent, theHeap.size(), kOpenList));
+        if (parent == kTAStarNoNode)
+            elements.back().parentID = elements.size() - 1;
+        slot.id[side] = elements.size() - 1;
+        theHeap.push_back(elements.size() - 1);
+        HeapifyUp(theHeap.size() - 1);
+        return elements.size() - 1;
+    }
+
+    /**
+     * Returns location of object as well as object key.
+     */
+    dataLocation Lookup(uint64_t hashKey, uint64_t &objKey) const { return Lookup(sharedIndex->Find(hashKey), objKey); }
+
+    /**
+     * Same as above, for a slot already found in the shared index (or nullptr)
+     */
+    dataLocation Lookup(const BDSharedSlot *slot, uint64_t &objKey) const {
+        if (slot == nullptr || slot->id[side] == kTAStarNoNode)
+            return kNotFound;
+        objKey = slot->id[side];
+        return elements[objKey].where;
+    }
+
+    inline dataStructure &Lookup(uint64_t objKey) { return elements[objKey]; }
+
+    inline const dataStructure &Lookat(uint64_t objKey) const { return elements[objKey]; }
+
+    /**
+     * Indicate that the key for a particular object has changed.
+     */
+    void KeyChanged(uint64_t objKey) {
+        if (!HeapifyUp(elements[objKey].openLocation))
+            HeapifyDown(elements[objKey].openLocation);
+    }
+
+    /**
+     * Peek at the next item to be expanded.
+     */
+    uint64_t Peek() const {
+        assert(OpenSize() != 0);
+        return theHeap[0];
+    }
+
+    /**
+     * Move the best item to the closed list and return key.
+     */
+    uint64_t Close() {
+        assert(OpenSize() != 0);
+        uint64_t ans = theHeap[0];
+        elements[ans].where = kClosedList;
+        theHeap[0] = theHeap[theHeap.size() - 1];
+        elements[theHeap[0]].openLocation = 0;
+        theHeap.pop_back();
+        HeapifyDown(0);
+        return ans;
+    }
+
+    /**
+     * Move item off the closed list and back onto the open list.
+     */
+    void Reopen(uint64_t objKey) {
+        assert(elements[objKey].where == kClosedList);
+        elements[objKey].reopened = true;
+        elements[objKey].where = kOpenList;
+        elements[objKey].openLocation = theHeap.size();
+        theHeap.push_back(objKey);
+        HeapifyUp(theHeap.size() - 1);
+    }
+
+    uint64_t GetOpenItem(unsigned int which) { return theHeap[which]; }
+
+    size_t OpenSize() const { return theHeap.size(); }
+
+    size_t ClosedSize() const { return size() - OpenSize(); }
+
+    size_t size() const { return elements.size(); }
+
+    bool empty() const { return theHeap.size() == 0; }
+
+private:
+    /**
+     * Moves a node up the heap. Returns true if the node was moved, false otherwise.
+     */
+    bool HeapifyUp(uint64_t index) {
+        if (index == 0) return false;
+        int parent = (index - 1) / 2;
+        CmpKey compare;
+
+        if (compare(elements[theHeap[parent]], elements[theHeap[index]])) {
+            unsigned int tmp = theHeap[parent];
+            theHeap[parent] = theHeap[index];
+            theHeap[index] = tmp;
+            elements[theHeap[parent]].openLocation = parent;
+            elements[theHeap[index]].openLocation = index;
+            HeapifyUp(parent);
+            return true;
+        }
+        return false;
+    }
+
+    void HeapifyDown(uint64_t index) {
+        CmpKey compare;
+        unsigned int child1 = index * 2 + 1;
+        unsigned int child2 = index * 2 + 2;
+        int which;
+        unsigned int count = theHeap.size();
+        // find smallest child
+        if (child1 >= count)
+            return;
+        else if (child2 >= count)
+            which = child1;
+        else if (!(compare(elements[theHeap[child1]], elements[theHeap[child2]])))
+            which = child1;
+        else
+            which = child2;
+
+        if (!(compare(elements[theHeap[which]], elements[theHeap[index]]))) {
+            unsigned int tmp = theHeap[which];
+            theHeap[which] = theHeap[index];
+            theHeap[index] = tmp;
+            elements[theHeap[which]].openLocation = which;
+            elements[theHeap[index]].openLocation = index;
+            HeapifyDown(which);
+        }
+    }
+
+    indexType *sharedIndex;
+    int side; // Which of the ids of a slot belongs to this list
+    std::vector<uint64_t> theHeap;
+    std::vector<dataStructure> elements;
+};
+
+#endif
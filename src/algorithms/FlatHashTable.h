@@ -0,0 +1,195 @@
+/*
+ *  FlatHashTable.h
+ *
+ *  An open-addressing hash table from 64-bit state hashes to small values, used as the index of the open/closed
+ *  lists in place of std::unordered_map.
+ */
+
+#ifndef FLATHASHTABLE_H
+#define FLATHASHTABLE_H
+
+#include <cassert>
+#include <cstddef>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/**
+ * All entries live in one array, probed linearly with robin-hood ordering: an entry is kept at least as close to its
+ * home slot as any entry it was inserted past, so a lookup can stop as soon as it meets an entry closer to its own
+ * home than the searched key would be. A hit or a miss usually costs a single cache line, instead of the bucket and
+ * node pointers chased by std::unordered_map.
+ *
+ * State hashes are often ranks or packed coordinates, whose low bits are far from uniform, so keys are mixed before
+ * they pick their home slot.
+ *
+ * Inserting may move the entries, so a pointer to a value is valid only until the next Insert (or Erase, or clear).
+ */
+template<typename value>
+class FlatHashTable {
+public:
+    FlatHashTable() : mask(0), count(0) {}
+
+    /**
+     * Removes all entries. The slots keep their capacity for the next search.
+     */
+    void clear() {
+        if (count == 0)
+            return;
+        for (auto &slot: slots)
+            slot.distance = 0;
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    /**
+     * @return The value of the given key, nullptr if it is not in the table
+     */
+    value *Find(uint64_t key) {
+        size_t i = FindSlot(key);
+        return i == kNone ? nullptr : &slots[i].val;
+    }
+
+    const value *Find(uint64_t key) const {
+        size_t i = FindSlot(key);
+        return i == kNone ? nullptr : &slots[i].val;
+    }
+
+    /**
+     * @return The value of the given key, default-constructed and inserted if it is not in the table
+     */
+    value &Insert(uint64_t key) {
+        size_t i = FindSlot(key);
+        if (i != kNone)
+            return slots[i].val;
+        if ((count + 1) * kMaxLoadDenominator > slots.size() * kMaxLoadNumerator)
+            Grow();
+        count++;
+        return slots[Place(key, value())].val;
+    }
+
+    value &operator[](uint64_t key) { return Insert(key); }
+
+    /**
+     * Removes the given key, shifting the entries probed after it back by one slot, so no tombstones are left
+     * @return Whether the key was in the table
+     */
+    bool Erase(uint64_t key) {
+        size_t i = FindSlot(key);
+        if (i == kNone)
+            return false;
+        for (size_t next = (i + 1) & mask; slots[next].distance > 1; next = (next + 1) & mask) {
+            slots[i] = std::move(slots[next]);
+            slots[i].distance--;
+            i = next;
+        }
+        slots[i].distance = 0;
+        count--;
+        return true;
+    }
+
+    /**
+     * Hints the processor to load the home slot of the given key. Issued for a batch of keys, for example all the
+     * successors of a state, before they are looked up, the cache misses of the lookups overlap instead of queueing.
+     */
+    void Prefetch(uint64_t key) const {
+#if defined(__GNUC__) || defined(__clang__)
+        if (!slots.empty())
+            __builtin_prefetch(&slots[Mix(key) & mask]);
+#endif
+    }
+
+    /**
+     * Looks up a batch of keys, prefetching all of their slots first
+     * @param results Receives the value of every key, nullptr for keys not in the table
+     */
+    void FindBatch(const uint64_t *keys, size_t num, value **results) {
+        for (size_t i = 0; i < num; i++)
+            Prefetch(keys[i]);
+        for (size_t i = 0; i < num; i++)
+            results[i] = Find(keys[i]);
+    }
+
+private:
+    struct Slot {
+        uint64_t key;
+        value val;
+        // 1 + the distance of the entry from its home slot, 0 for an empty slot
+        uint32_t distance;
+    };
+
+    static const size_t kNone = ~size_t(0);
+    static const size_t kInitialSize = 1024;
+    // The table grows beyond 7/8 full, which robin-hood probing keeps short
+    static const size_t kMaxLoadNumerator = 7;
+    static const size_t kMaxLoadDenominator = 8;
+
+    /**
+     * The finalizer of MurmurHash3, which spreads every bit of the key over the whole word
+     */
+    static uint64_t Mix(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    size_t FindSlot(uint64_t key) const {
+        if (count == 0)
+            return kNone;
+        size_t i = Mix(key) & mask;
+        for (uint32_t distance = 1;; distance++) {
+            const Slot &slot = slots[i];
+            // An entry closer to its home than the key would be means the key was never placed past it
+            if (slot.distance < distance)
+                return kNone;
+            if (slot.key == key)
+                return i;
+            i = (i + 1) & mask;
+        }
+    }
+
+    /**
+     * Places a key which is not in the table, displacing entries farther from their homes
+     * @return The slot the key was placed in
+     */
+    size_t Place(uint64_t key, value val) {
+        Slot entry{key, std::move(val), 1};
+        size_t placed = kNone;
+        for (size_t i = Mix(key) & mask;; i = (i + 1) & mask, entry.distance++) {
+            Slot &slot = slots[i];
+            if (slot.distance == 0) {
+                slot = std::move(entry);
+                return placed == kNone ? i : placed;
+            }
+            if (slot.distance < entry.distance) {
+                std::swap(slot, entry);
+                if (placed == kNone)
+                    placed = i;
+            }
+        }
+    }
+
+    void Grow() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(old.empty() ? kInitialSize : old.size() * 2);
+        for (auto &slot: slots)
+            slot.distance = 0;
+        mask = slots.size() - 1;
+        for (auto &slot: old)
+            if (slot.distance != 0)
+                Place(slot.key, std::move(slot.val));
+    }
+
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t count;
+};
+
+#endif //FLATHASHTABLE_H
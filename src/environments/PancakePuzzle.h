@@ -439,7 +439,7 @@ double PancakePuzzle<N>::HCost(const PancakePuzzleState<N> &state, const Pancake
 	if (use_memory_free)
 	{
 		//assert(!"This code allocates a vector; re-write to be more efficient");
-		static std::vector<int> goal_locs(N);
+		thread_local static std::vector<int> goal_locs(N);
 		for (unsigned i = 0; i < N; i++)
 		{
 			goal_locs[goal_state.puzzle[i]] = i;
@@ -16,25 +16,59 @@
 #define BAE_H
 
 #include "AStarOpenClosed.h"
+#include "BDSharedOpenClosed.h"
 #include "FPUtil.h"
 #include "Timer.h"
-#include <unordered_map>
+#include "SearchLimits.h"
+#include "BoundStatistics.h"
+#include "CostType.h"
+#include "DirectionPolicy.h"
 #include <cmath>
 #include <iostream>
 #include "Heuristic.h"
 #include <vector>
 #include <algorithm>
 
-template<class state>
+/**
+ * The node record of BAE*. As in AStarOpenClosedData, h holds the b-value of the node, which is its priority. The
+ * heuristic values of the state towards the target and the source are kept as well, so they are computed once when the
+ * state is generated, and reused for pruning and for the statistics gathered after the search. The hash of the state is
+ * kept too, so the slot of the state in the index shared by the directions is found without hashing it again.
+ * The costs are of the given type, see CostType.h.
+ */
+template<typename state, typename cost = double>
+class BAEOpenClosedData {
+public:
+    BAEOpenClosedData() {}
+
+    BAEOpenClosedData(const state &theData, cost gCost, cost bValue, uint64_t parent, uint64_t openLoc,
+                      dataLocation location)
+            : data(theData), parentID(parent), openLocation(openLoc), g(gCost), h(bValue), hCost(0), rhCost(0),
+              hash(0), where(location), reopened(false) {}
+
+    state data;
+    uint64_t parentID;
+    uint64_t openLocation;
+    cost g;
+    cost h; // The b-value
+    cost hCost; // Heuristic towards the target of the search direction
+    cost rhCost; // Heuristic towards the source of the search direction
+    uint64_t hash; // Hash of the state, set by the search when the node is added
+    dataLocation where;
+    bool reopened;
+};
+
+template<class state, class cost = double>
 struct BAECompare {
-    bool operator()(const AStarOpenClosedData<state> &i1, const AStarOpenClosedData<state> &i2) const {
+    bool operator()(const BAEOpenClosedData<state, cost> &i1, const BAEOpenClosedData<state, cost> &i2) const {
         // Note that h here is used to contain the b-value of a node, which is the priority of it.
-        double p1 = i1.h;
-        double p2 = i2.h;
-        if (fequal(p1, p2)) {
-            return (fless(i1.g, i2.g)); // high g-cost over low
+        typedef CostTraits<cost> costs;
+        cost p1 = i1.h;
+        cost p2 = i2.h;
+        if (costs::Equal(p1, p2)) {
+            return (costs::Less(i1.g, i2.g)); // high g-cost over low
         }
-        return (fgreater(p1, p2)); // low priority over high
+        return (costs::Greater(p1, p2)); // low priority over high
     }
 };
 
@@ -43,25 +77,31 @@ struct BAECompare {
  * A. "Bidirectional Heuristic Search based on Error Estimate" by Samir K Sadhukhan (2013).
  * B. "A Unifying View on Individual Bounds and Heuristic Inaccuracies in Bidirectional Search" by Vidal Alcázar, Pat
  * Riddle, Mike Barley (2020).
+ *
+ * The costs stored in the nodes, and the arithmetic done on them, are of the cost type of the records of the open list
+ * (double by default, see CostType.h). The costs given and returned by the public functions are always doubles.
  */
-template<class state, class action, class environment, class priorityQueue = AStarOpenClosed<state, BAECompare<state>>>
+template<class state, class action, class environment, class priorityQueue = BDSharedOpenClosed<state, BAECompare<state>, BAEOpenClosedData<state>>,
+        class statistics = BoundHistogram, class direction = AlternatingDirection, class fStatistics = FCostHistogram>
 class BAE {
 public:
     /**
-     *
-     * @param alternating_ Is the side choosing policy alternating or Pohl's cardinality criterion
+     * The side-choosing policy is the direction template parameter, see DirectionPolicy.h
      * @param epsilon_ Cost of the least-cost edge
      * @param gcd_ Greatest common denominator between all edges. Note that for edges e.g., 1 and 1.5, the gcd is 0.5.
      */
 
-    BAE(bool alternating_ = true, double epsilon_ = 1.0, double gcd_ = 1.0) {
+    BAE(double epsilon_ = 1.0, double gcd_ = 1.0) {
         forwardHeuristic = 0;
         backwardHeuristic = 0;
         env = 0;
         ResetNodeCount();
-        epsilon = epsilon_;
         gcd = gcd_;
-        alternating = alternating_;
+        epsilon = costs::Edge(epsilon_, gcd);
+        forwardQueue.SetIndex(&nodeIndex, 0);
+        backwardQueue.SetIndex(&nodeIndex, 1);
+        forwardQueue.SetGranularity(costs::Granularity(gcd));
+        backwardQueue.SetGranularity(costs::Granularity(gcd));
     }
 
     virtual ~BAE() {}
@@ -76,15 +116,18 @@ public:
 
     virtual const char *GetName() { return "BAE"; }
 
-    void ResetNodeCount() { nodesExpanded = nodesTouched = uniqueNodesExpanded = 0; }
+    void ResetNodeCount() {
+        nodesExpanded = nodesTouched = uniqueNodesExpanded = 0;
+        sideExpansions[0] = sideExpansions[1] = 0;
+    }
 
     inline const int GetNumForwardItems() { return forwardQueue.size(); }
 
-    inline const AStarOpenClosedData<state> &GetForwardItem(unsigned int which) { return forwardQueue.Lookat(which); }
+    inline const auto &GetForwardItem(unsigned int which) { return forwardQueue.Lookat(which); }
 
     inline const int GetNumBackwardItems() { return backwardQueue.size(); }
 
-    inline const AStarOpenClosedData<state> &GetBackwardItem(unsigned int which) {
+    inline const auto &GetBackwardItem(unsigned int which) {
         return backwardQueue.Lookat(which);
     }
 
@@ -94,21 +137,77 @@ public:
 
     uint64_t GetNodesTouched() const { return nodesTouched; }
 
-    uint64_t GetNecessaryExpansions() {
-        uint64_t necessary = 0;
-        for (const auto &count: counts) {
-            if (count.first < currentCost)
-                necessary += count.second;
-        }
-        return necessary;
-    }
+    /**
+     * @return The number of expansions done while the lower bound was below the solution cost, 0 if the statistics
+     * policy does not record them
+     */
+    uint64_t GetNecessaryExpansions() const { return boundStatistics.CountBelow(ToDouble(currentCost)); }
 
+    /**
+     * @return The number of closed nodes with f-cost above cstar. Read from the f-cost statistics if they are recorded,
+     * otherwise counted by scanning both closed lists.
+     */
     int GetNumOfExpandedWithFGreaterC(float cstar);
 
+    /**
+     * Sets the resource budgets used by every following search
+     */
+    void SetLimits(const SearchLimits &limits) { limiter.SetLimits(limits); }
+
+    SearchStatus GetSearchStatus() const { return limiter.GetStatus(); }
+
+    /**
+     * @return The best lower bound proven by the last search, which is the solution cost if it was solved
+     */
+    double GetBestLowerBound() const { return ToDouble(limiter.Solved() ? currentCost : bestLowerBound); }
+
+    /**
+     * @return The cost of the best solution found by the last search, DBL_MAX if none was found
+     */
+    double GetBestUpperBound() const { return ToDouble(currentCost); }
+
+    const direction &GetDirectionPolicy() const { return directionPolicy; }
+
 	void Draw(Graphics::Display &d) const;
 	void Draw(Graphics::Display &d, const priorityQueue &q) const;
 
 private:
+    // The cost type of the search is that of the g-costs in the records of its open list
+    typedef typename std::decay<decltype(std::declval<priorityQueue &>().Lookup(uint64_t(0)).g)>::type cost;
+    typedef CostTraits<cost> costs;
+
+    double ToDouble(cost value) const { return costs::ToDouble(value, gcd); }
+
+    /**
+     * The view of the two sides given to the direction policy. Its values are only computed if the policy reads them.
+     */
+    class Sides {
+    public:
+        explicit Sides(const BAE &search_) : search(search_) {}
+
+        size_t OpenSize(bool forward) const { return Queue(forward).OpenSize(); }
+
+        double TopB(bool forward) const { return Empty(forward) ? DBL_MAX : search.ToDouble(Top(forward).h); }
+
+        double TopF(bool forward) const {
+            return Empty(forward) ? DBL_MAX : search.ToDouble(Top(forward).g + Top(forward).hCost);
+        }
+
+        double TopG(bool forward) const { return Empty(forward) ? DBL_MAX : search.ToDouble(Top(forward).g); }
+
+        uint64_t Expansions(bool forward) const { return search.sideExpansions[forward ? 0 : 1]; }
+
+        uint64_t Generated() const { return search.nodesTouched; }
+
+    private:
+        const priorityQueue &Queue(bool forward) const { return forward ? search.forwardQueue : search.backwardQueue; }
+
+        bool Empty(bool forward) const { return Queue(forward).OpenSize() == 0; }
+
+        const auto &Top(bool forward) const { return Queue(forward).Lookat(Queue(forward).Peek()); }
+
+        const BAE &search;
+    };
 
     void Nip(const state &, priorityQueue &reverse);
 
@@ -141,42 +240,51 @@ private:
     }
 
     void Expand(priorityQueue &current, priorityQueue &opposite, Heuristic<state> *heuristic,
-                Heuristic<state> *reverse_heuristic, const state &target, const state &source);
+                Heuristic<state> *reverse_heuristic, const state &target, const state &source, cost lowerBound);
 
-    double getLowerBound();
+    cost getLowerBound();
 
+    typename priorityQueue::index nodeIndex; // Finds the records of a state in both directions with a single probe
     priorityQueue forwardQueue, backwardQueue;
     state goal, start;
     uint64_t nodesTouched, nodesExpanded, uniqueNodesExpanded;
     state middleNode; // Meeting point of the current solution
-    double currentCost; // Cost of the best solution found so far
+    cost currentCost; // Cost of the best solution found so far
+    cost bestLowerBound; // Highest lower bound seen so far, reported when the search is stopped by a limit
 
     std::vector<state> neighbors;
+    std::vector<uint64_t> neighborHashes;
     environment *env;
     Heuristic<state> *forwardHeuristic;
     Heuristic<state> *backwardHeuristic;
 
-    double epsilon; // Cost of the least-cost edge
+    cost epsilon; // Cost of the least-cost edge
     double gcd; // Greatest common denominator between all edges
 
-    bool alternating; // Is the side-choosing policy alternating or not
-    bool expandForward; // Is the current expansion direction forward. This is used for the alternating policy
+    direction directionPolicy; // Chooses the side of every expansion
+    uint64_t sideExpansions[2]; // Number of expansions chosen on the forward and backward sides
+
+    statistics boundStatistics; // Number of expansions done at every value of the lower bound
+    fStatistics fCostStatistics; // Number of closed nodes at every f-cost
 
-    std::unordered_map<double, int> counts;
+    SearchLimiter limiter;
 };
 
-template<class state, class action, class environment, class priorityQueue>
-int BAE<state, action, environment, priorityQueue>::GetNumOfExpandedWithFGreaterC(float cstar) {
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+int BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::GetNumOfExpandedWithFGreaterC(float cstar) {
+    if (fStatistics::kEnabled)
+        return fCostStatistics.CountAbove(cstar);
     int count=0;
     for (int i = 0; i < forwardQueue.size(); ++i) {
         auto &n = forwardQueue.Lookup(i);
-        if(n.where == kClosedList && n.g + forwardHeuristic->HCost(n.data, goal) > cstar){
+        if(n.where == kClosedList && ToDouble(n.g + n.hCost) > cstar){
             count++;
         }
     }
     for (int i = 0; i < backwardQueue.size(); ++i) {
         auto &n = backwardQueue.Lookup(i);
-        if(n.where == kClosedList && n.g + backwardHeuristic->HCost(n.data, start) > cstar){
+        if(n.where == kClosedList && ToDouble(n.g + n.hCost) > cstar){
             count++;
         }
     }
@@ -186,17 +294,17 @@ int BAE<state, action, environment, priorityQueue>::GetNumOfExpandedWithFGreater
  * Calculates the current lower-bound bases on min b in both sides, uses the gcd trick from Alcázar et al.
  * @return Current lower-bound on the search
  */
-template<class state, class action, class environment, class priorityQueue>
-double BAE<state, action, environment, priorityQueue>::getLowerBound() {
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+auto BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::getLowerBound() -> cost {
     if (forwardQueue.OpenSize() == 0 || backwardQueue.OpenSize() == 0)
-        return DBL_MAX;
+        return costs::Infinity();
 
-    double totalErrorForward = forwardQueue.Lookup(forwardQueue.Peek()).h;
-    double totalErrorBackward = backwardQueue.Lookup(backwardQueue.Peek()).h;
-    double unroundedLowerBound = (totalErrorForward + totalErrorBackward) / 2;
+    cost totalErrorForward = forwardQueue.Lookup(forwardQueue.Peek()).h;
+    cost totalErrorBackward = backwardQueue.Lookup(backwardQueue.Peek()).h;
 
     // round up to the next multiple of gcd
-    return ceil(unroundedLowerBound / gcd) * gcd;
+    return costs::HalfRoundedUp(totalErrorForward, totalErrorBackward, gcd);
 }
 
 /**
@@ -208,8 +316,9 @@ double BAE<state, action, environment, priorityQueue>::getLowerBound() {
  * @param backward A backward heuristic, i.e., a heuristic from the start to some node n
  * @param thePath The solution path which we will fill when the search is done
  */
-template<class state, class action, class environment, class priorityQueue>
-void BAE<state, action, environment, priorityQueue>::GetPath(environment *env, const state &from, const state &to,
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+void BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::GetPath(environment *env, const state &from, const state &to,
                                                              Heuristic<state> *forward, Heuristic<state> *backward,
                                                              std::vector<state> &thePath) {
     if (InitializeSearch(env, from, to, forward, backward, thePath) == false)
@@ -227,8 +336,9 @@ void BAE<state, action, environment, priorityQueue>::GetPath(environment *env, c
  * @param thePath The solution path which we will fill when the search is done
  * @return whether the start and goal are not the same (false means they are the same)
  */
-template<class state, class action, class environment, class priorityQueue>
-bool BAE<state, action, environment, priorityQueue>::InitializeSearch(environment *env, const state &from,
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+bool BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::InitializeSearch(environment *env, const state &from,
                                                                       const state &to,
                                                                       Heuristic<state> *forward,
                                                                       Heuristic<state> *backward,
@@ -236,20 +346,36 @@ bool BAE<state, action, environment, priorityQueue>::InitializeSearch(environmen
     this->env = env;
     forwardHeuristic = forward;
     backwardHeuristic = backward;
-    currentCost = DBL_MAX;
+    currentCost = costs::Infinity();
+    bestLowerBound = 0;
+    limiter.Start();
+    nodeIndex.Reset(env->GetMaxHash());
     forwardQueue.Reset();
     backwardQueue.Reset();
     ResetNodeCount();
+    boundStatistics.Reset(gcd);
+    fCostStatistics.Reset();
     thePath.resize(0);
     start = from;
     goal = to;
-    if (start == goal)
+    if (start == goal) {
+        currentCost = 0;
         return false;
+    }
 
-    forwardQueue.AddOpenNode(start, env->GetStateHash(start), 0, forwardHeuristic->HCost(start, goal));
-    backwardQueue.AddOpenNode(goal, env->GetStateHash(goal), 0, backwardHeuristic->HCost(goal, start));
-
-    expandForward = true;
+    // The reverse heuristic of a root is its heuristic to itself, i.e., 0
+    cost hStart = costs::Heuristic(forwardHeuristic->HCost(start, goal), gcd);
+    uint64_t startHash = env->GetStateHash(start);
+    auto &startData = forwardQueue.Lookup(forwardQueue.AddOpenNode(start, startHash, 0, hStart));
+    startData.hCost = hStart;
+    startData.hash = startHash;
+    cost hGoal = costs::Heuristic(backwardHeuristic->HCost(goal, start), gcd);
+    uint64_t goalHash = env->GetStateHash(goal);
+    auto &goalData = backwardQueue.Lookup(backwardQueue.AddOpenNode(goal, goalHash, 0, hGoal));
+    goalData.hCost = hGoal;
+    goalData.hash = goalHash;
+
+    directionPolicy.Reset();
     return true;
 }
 
@@ -258,16 +384,16 @@ bool BAE<state, action, environment, priorityQueue>::InitializeSearch(environmen
  * @param thePath The solution path which we will fill when the search is done
  * @return Wether the search was done or not
  */
-template<class state, class action, class environment, class priorityQueue>
-bool BAE<state, action, environment, priorityQueue>::DoSingleSearchStep(std::vector<state> &thePath) {
-    if ((forwardQueue.OpenSize() == 0 || backwardQueue.OpenSize() == 0) && currentCost == DBL_MAX) {
-        std::cerr << " !! Problem with no solution?? Expanded: " << nodesExpanded << std::endl;
-        exit(0);
-    }
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+bool BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::DoSingleSearchStep(std::vector<state> &thePath) {
+    if ((forwardQueue.OpenSize() == 0 || backwardQueue.OpenSize() == 0) && currentCost == costs::Infinity())
+        return limiter.Stop(SearchStatus::Unsolvable);
 
     // This means that the best solution so far is better (or equal) than any solution we will be able to achieve from
     // this point forward, i.e., we are done
-    if (currentCost <= getLowerBound()) {
+    cost lowerBound = getLowerBound();
+    if (currentCost <= lowerBound) {
         std::vector<state> pFor, pBack;
         ExtractPathToGoal(middleNode, pBack);
         ExtractPathToStart(middleNode, pFor);
@@ -277,21 +403,18 @@ bool BAE<state, action, environment, priorityQueue>::DoSingleSearchStep(std::vec
 
         return true;
     }
+    bestLowerBound = std::max(bestLowerBound, lowerBound);
 
-    // If we are not done, expand a single node based on the side-choosing policy set by the user
-    if (alternating) { // original BAE* definition
-        if (expandForward) {
-            Expand(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
-            expandForward = false;
-        } else {
-            Expand(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
-            expandForward = true;
-        }
-    } else { // BS* policy, roughly Pohl's criterion
-        if (forwardQueue.OpenSize() > backwardQueue.OpenSize())
-            Expand(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
-        else
-            Expand(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
+    if (limiter.Exceeded(nodesExpanded))
+        return true;
+
+    // If we are not done, expand a single node based on the side-choosing policy
+    if (directionPolicy.ExpandForward(Sides(*this))) {
+        sideExpansions[0]++;
+        Expand(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start, lowerBound);
+    } else {
+        sideExpansions[1]++;
+        Expand(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal, lowerBound);
     }
 
     return false;
@@ -305,20 +428,27 @@ bool BAE<state, action, environment, priorityQueue>::DoSingleSearchStep(std::vec
  * @param reverse_heuristic The heuristic for the opposite direction
  * @param target The node we are aiming for (goal in forward, start in backward)
  * @param source The node we started from, opposite of target
+ * @param lowerBound The lower bound checked before choosing the node, recorded in the statistics of the expansion
  */
-template<class state, class action, class environment, class priorityQueue>
-void BAE<state, action, environment, priorityQueue>::Expand(priorityQueue &current, priorityQueue &opposite,
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+void BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::Expand(priorityQueue &current, priorityQueue &opposite,
                                                             Heuristic<state> *heuristic,
                                                             Heuristic<state> *reverse_heuristic,
-                                                            const state &target, const state &source) {
+                                                            const state &target, const state &source,
+                                                            cost lowerBound) {
     uint64_t nextID;
     bool success = false;
     // This does lazy nipping, which means we do not we do not expand a node that was already closed in the opposite
     // direction. We search until we find one that is not closed
     while (current.OpenSize() > 0) {
         nextID = current.Close();
+        // Nodes skipped by the nipping are closed as well, and counted like the expanded ones
+        if (fStatistics::kEnabled)
+            fCostStatistics.Add(ToDouble(current.Lookup(nextID).g + current.Lookup(nextID).hCost));
+        // The hash kept in the record finds the slot, which holds the record of the opposite direction
         uint64_t reverseLoc;
-        auto loc = opposite.Lookup(env->GetStateHash(current.Lookup(nextID).data), reverseLoc);
+        auto loc = opposite.Lookup(nodeIndex.Find(current.Lookup(nextID).hash), reverseLoc);
         if (loc != kClosedList) {
             success = true;
             break;
@@ -332,30 +462,44 @@ void BAE<state, action, environment, priorityQueue>::Expand(priorityQueue &curre
     bool foundBetterSolution = false;
     nodesExpanded++;
 
-    // This is to update for necessary expansions
-    counts[getLowerBound()] += 1;
+    // This is to update for necessary expansions, with the bound the search step already computed. The histogram only
+    // flushes when the bound changes, and without statistics this is compiled out
+    if (statistics::kEnabled)
+        boundStatistics.Add(ToDouble(lowerBound));
 
     if (current.Lookup(nextID).reopened == false)
         uniqueNodesExpanded++;
 
     env->GetSuccessors(current.Lookup(nextID).data, neighbors);
-    for (auto &succ: neighbors) {
+    // Hash all the successors first, so the cache misses of their probes of the index overlap
+    neighborHashes.resize(neighbors.size());
+    for (size_t i = 0; i < neighbors.size(); i++) {
+        neighborHashes[i] = env->GetStateHash(neighbors[i]);
+        nodeIndex.Prefetch(neighborHashes[i]);
+    }
+    for (size_t i = 0; i < neighbors.size(); i++) {
+        const state &succ = neighbors[i];
         nodesTouched++;
         uint64_t childID;
-        uint64_t hash = env->GetStateHash(succ);
-        auto loc = current.Lookup(hash, childID);
+        uint64_t hash = neighborHashes[i];
+        // The slot holds the records of the state in both directions, so this is the only probe of the index
+        BDSharedSlot *slot = nodeIndex.Find(hash);
+        auto loc = current.Lookup(slot, childID);
         auto &childData = current.Lookup(childID);
         auto &parentData = current.Lookup(nextID);
 
-        double edgeCost = env->GCost(parentData.data, succ);
+        cost edgeCost = costs::Edge(env->GCost(parentData.data, succ), gcd);
+
+        // The heuristic of a state is computed only when it is first generated, and is then read from its record
+        cost h = loc == kNotFound ? costs::Heuristic(heuristic->HCost(succ, target), gcd) : childData.hCost;
 
         // ignore states with greater cost than best solution
-        if (fgreatereq(parentData.g + edgeCost+heuristic->HCost(succ, target), currentCost))
+        if (costs::GreaterEq(parentData.g + edgeCost + h, currentCost))
             continue;
 
         switch (loc) {
             case kClosedList: // Since BAE* requires a consistent heuristic, this situation should be impossible
-                if (fless(parentData.g + edgeCost, childData.g)) {
+                if (costs::Less(parentData.g + edgeCost, childData.g)) {
                     std::cerr << "  Expanded with non optimal g??????? " << std::endl;
                     exit(0);
                     childData.h = std::max(childData.h, parentData.h - edgeCost);
@@ -366,9 +510,9 @@ void BAE<state, action, environment, priorityQueue>::Expand(priorityQueue &curre
                 break;
             case kOpenList: // Update cost if needed
             {
-                if (fless(parentData.g + edgeCost, childData.g)) {
+                if (costs::Less(parentData.g + edgeCost, childData.g)) {
                     childData.parentID = nextID;
-                    double gDiff = childData.g - (parentData.g + edgeCost);
+                    cost gDiff = childData.g - (parentData.g + edgeCost);
                     childData.g = parentData.g + edgeCost;
                     // Modify total error accordingly. Since b uses 2g in the formula, and we reduced g (as h and h_r
                     // are static), all that needs to change is 2 times the difference
@@ -377,9 +521,9 @@ void BAE<state, action, environment, priorityQueue>::Expand(priorityQueue &curre
 
                     // Check if we found a potential solution
                     uint64_t reverseLoc;
-                    auto loc = opposite.Lookup(hash, reverseLoc);
+                    auto loc = opposite.Lookup(slot, reverseLoc);
                     if (loc == kOpenList) {
-                        if (fless(parentData.g + edgeCost + opposite.Lookup(reverseLoc).g, currentCost)) {
+                        if (costs::Less(parentData.g + edgeCost + opposite.Lookup(reverseLoc).g, currentCost)) {
                             foundBetterSolution = true;
                             currentCost = parentData.g + edgeCost + opposite.Lookup(reverseLoc).g;
                             middleNode = succ;
@@ -389,22 +533,29 @@ void BAE<state, action, environment, priorityQueue>::Expand(priorityQueue &curre
             }
                 break;
             case kNotFound: {
-                double g = parentData.g + edgeCost;
-                double h = std::max(heuristic->HCost(succ, target), epsilon);
+                cost g = parentData.g + edgeCost;
+                cost hBounded = std::max(h, epsilon);
 
                 // Ignore nodes that don't have lower f-cost than the incumbent solution
-                if (!fless(g + h, currentCost))
+                if (!costs::Less(g + hBounded, currentCost))
                     break;
 
-                double totalError = (2 * g) + h - reverse_heuristic->HCost(succ, source);
+                cost rh = costs::Heuristic(reverse_heuristic->HCost(succ, source), gcd);
+                cost totalError = (2 * g) + hBounded - rh;
 
-                current.AddOpenNode(succ, hash, g, totalError, nextID);
+                // Only a state that neither direction has seen needs a new slot
+                if (slot == nullptr)
+                    slot = &nodeIndex.Insert(hash);
+                auto &newData = current.Lookup(current.AddOpenNode(succ, *slot, g, totalError, nextID));
+                newData.hCost = h;
+                newData.rhCost = rh;
+                newData.hash = hash;
 
                 // Check if we found a potential solution
                 uint64_t reverseLoc;
-                auto loc = opposite.Lookup(hash, reverseLoc);
+                auto loc = opposite.Lookup(slot, reverseLoc);
                 if (loc == kOpenList) {
-                    if (fless(current.Lookup(nextID).g + edgeCost + opposite.Lookup(reverseLoc).g, currentCost)) {
+                    if (costs::Less(current.Lookup(nextID).g + edgeCost + opposite.Lookup(reverseLoc).g, currentCost)) {
                         foundBetterSolution = true;
                         currentCost = current.Lookup(nextID).g + edgeCost + opposite.Lookup(reverseLoc).g;
                         middleNode = succ;
@@ -422,8 +573,9 @@ void BAE<state, action, environment, priorityQueue>::Expand(priorityQueue &curre
  * @param reverse The openClosed list in the opposite direction to which the state was expanded from
  * @deprecated
  */
-template<class state, class action, class environment, class priorityQueue>
-void BAE<state, action, environment, priorityQueue>::Nip(const state &s, priorityQueue &reverse)
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+void BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::Nip(const state &s, priorityQueue &reverse)
 {
     assert(!"Not using this code currently - the correct implementation of 'remove' is unclear from BS*");
     // At this point parent has been removed from open
@@ -469,15 +621,17 @@ void BAE<state, action, environment, priorityQueue>::Nip(const state &s, priorit
         }
     }
 }
-template<class state, class action, class environment, class priorityQueue>
-void BAE<state, action, environment, priorityQueue>::Draw(Graphics::Display &disp) const
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+void BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::Draw(Graphics::Display &disp) const
 {
 	Draw(disp, forwardQueue);
 	Draw(disp, backwardQueue);
 }
 
-template<class state, class action, class environment, class priorityQueue>
-void BAE<state, action, environment, priorityQueue>::Draw(Graphics::Display &disp, const priorityQueue &q) const
+template<class state, class action, class environment, class priorityQueue, class statistics, class direction,
+        class fStatistics>
+void BAE<state, action, environment, priorityQueue, statistics, direction, fStatistics>::Draw(Graphics::Display &disp, const priorityQueue &q) const
 {
 	double transparency = 1.0;
 	if (q.size() == 0)
@@ -0,0 +1,164 @@
+/**
+ * @file BoundStatistics.h
+ * @package hog2
+ * @brief Statistics policies counting the expansions done at every value of a search's lower bound, and the nodes
+ * closed at every f-cost
+ *
+ * A search takes one of the policies as a template parameter and reports the lower bound of each of its expansions.
+ * BoundHistogram keeps the counts in a dense array indexed by the bound in gcd units, which is what the necessary
+ * expansions are computed from. NoBoundStatistics records nothing, and since its kEnabled is false the search does not
+ * even compute the bound, so a search that does not need the statistics pays nothing for them.
+ *
+ * Likewise, a search reports the f-cost of every node it closes to an f-cost policy. FCostHistogram answers how many
+ * closed nodes have f above C* (fabove) without scanning the closed lists after the search; with NoFCostStatistics the
+ * search falls back to that scan.
+ */
+
+#ifndef BOUNDSTATISTICS_H
+#define BOUNDSTATISTICS_H
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Counts expansions per lower bound. The bounds are multiples of the gcd of the edge costs, so bound / gcd is a small
+ * integer and indexes the histogram directly. Successive expansions mostly share the same bound, so they are counted
+ * in a run which is only added to the histogram once the bound changes.
+ */
+class BoundHistogram {
+public:
+    static const bool kEnabled = true;
+
+    /**
+     * Clears the counts for a new search
+     * @param gcd_ Greatest common denominator between all edges, of which every bound is a multiple
+     */
+    void Reset(double gcd_) {
+        gcd = gcd_;
+        bins.clear(); // Keeps its capacity for the next search
+        runBound = DBL_MAX;
+        runLength = 0;
+    }
+
+    /**
+     * Records a single expansion done while the lower bound was the given one
+     */
+    void Add(double bound) {
+        if (bound != runBound) {
+            Flush();
+            runBound = bound;
+        }
+        runLength++;
+    }
+
+    /**
+     * @return The number of expansions done while the lower bound was smaller than the given cost
+     */
+    uint64_t CountBelow(double cost) const {
+        uint64_t count = 0;
+        for (size_t bin = 0; bin < bins.size(); ++bin) {
+            if (bin * gcd < cost)
+                count += bins[bin];
+        }
+        if (runBound < cost && runBound != DBL_MAX)
+            count += runLength;
+        return count;
+    }
+
+private:
+    void Flush() {
+        // Expansions done while a side had no open nodes have no finite bound and are never below a solution cost
+        if (runLength == 0 || runBound == DBL_MAX) {
+            runLength = 0;
+            return;
+        }
+        size_t bin = runBound > 0 ? static_cast<size_t>(std::llround(runBound / gcd)) : 0;
+        if (bin >= bins.size())
+            bins.resize(bin + 1, 0);
+        bins[bin] += runLength;
+        runLength = 0;
+    }
+
+    double gcd = 1.0;
+    std::vector<uint64_t> bins; // Number of expansions done at the bound bin * gcd
+    double runBound = DBL_MAX; // Bound of the expansions not yet added to bins
+    uint64_t runLength = 0;
+};
+
+/**
+ * Records nothing, for runs that do not read the necessary expansions
+ */
+class NoBoundStatistics {
+public:
+    static const bool kEnabled = false;
+
+    void Reset(double) {}
+
+    void Add(double) {}
+
+    uint64_t CountBelow(double) const { return 0; }
+};
+
+/**
+ * Counts the closed nodes per f-cost. The f-costs are not multiples of the gcd in every domain (e.g., octile grids), so
+ * they are hashed exactly rather than binned, and counting the nodes above a cost takes O(#distinct f).
+ */
+class FCostHistogram {
+public:
+    static const bool kEnabled = true;
+
+    /**
+     * Clears the counts for a new search
+     */
+    void Reset() { counts.clear(); }
+
+    /**
+     * Records a node closed with the given f-cost
+     */
+    void Add(double f) { counts[f]++; }
+
+    /**
+     * Forgets a node recorded with the given f-cost, when it is reopened
+     */
+    void Remove(double f) {
+        auto it = counts.find(f);
+        if (it != counts.end() && --it->second == 0)
+            counts.erase(it);
+    }
+
+    /**
+     * @return The number of closed nodes with f-cost above the given cost
+     */
+    uint64_t CountAbove(double cost) const {
+        uint64_t count = 0;
+        for (const auto &entry: counts) {
+            if (entry.first > cost)
+                count += entry.second;
+        }
+        return count;
+    }
+
+private:
+    std::unordered_map<double, uint64_t> counts; // Number of closed nodes with every f-cost
+};
+
+/**
+ * Records nothing, for searches that count fabove by scanning their closed lists
+ */
+class NoFCostStatistics {
+public:
+    static const bool kEnabled = false;
+
+    void Reset() {}
+
+    void Add(double) {}
+
+    void Remove(double) {}
+
+    uint64_t CountAbove(double) const { return 0; }
+};
+
+#endif //BOUNDSTATISTICS_H
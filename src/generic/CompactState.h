@@ -0,0 +1,69 @@
+/**
+ * @file CompactState.h
+ * @package hog2
+ * @brief Packs a state into a smaller value, for searches which keep many states in their node records
+ *
+ * A search storing its states compactly packs a state when its node is created and unpacks it when the node is
+ * expanded, all through CompactState<state>. By default a state is kept as it is.
+ *
+ * Permutation states of at most 16 items, as the 15-puzzle and the 16-pancake, are packed four bits per item into a
+ * single word. Unlike the rank of the permutation (the state hash of both environments), packing and unpacking it takes
+ * a few shifts per item, and the 15-puzzle needs no parity to place its last two tiles.
+ */
+
+#ifndef COMPACTSTATE_H
+#define COMPACTSTATE_H
+
+#include <cstdint>
+#include <type_traits>
+
+template<int N>
+class PancakePuzzleState;
+
+template<int width, int height>
+class MNPuzzleState;
+
+template<class state, class enable = void>
+struct CompactState {
+    typedef state packed;
+
+    static void Pack(const state &s, packed &p) { p = s; }
+
+    static void Unpack(const packed &p, state &s) { s = p; }
+};
+
+/**
+ * The item at index i of the puzzle array is kept in bits 4i to 4i+3
+ */
+template<class state, int items>
+struct NibblePackedState {
+    static_assert(items <= 16, "Only 16 items of four bits fit a word");
+
+    typedef uint64_t packed;
+
+    static void Pack(const state &s, packed &p) {
+        p = 0;
+        for (int i = 0; i < items; i++)
+            p |= static_cast<uint64_t>(s.puzzle[i]) << (4 * i);
+    }
+
+    static void Unpack(packed p, state &s) {
+        for (int i = 0; i < items; i++) {
+            s.puzzle[i] = static_cast<int>(p & 0xF);
+            p >>= 4;
+        }
+        s.FinishUnranking(); // Finds the blank of the sliding-tile puzzle
+    }
+};
+
+template<int N>
+struct CompactState<PancakePuzzleState<N>, typename std::enable_if<(N <= 16)>::type>
+        : NibblePackedState<PancakePuzzleState<N>, N> {
+};
+
+template<int width, int height>
+struct CompactState<MNPuzzleState<width, height>, typename std::enable_if<(width * height <= 16)>::type>
+        : NibblePackedState<MNPuzzleState<width, height>, width * height> {
+};
+
+#endif //COMPACTSTATE_H
@@ -0,0 +1,90 @@
+/**
+ * @file CostType.h
+ * @package hog2
+ * @brief The arithmetic of the costs a search stores in its node records, for floating-point and integer costs
+ *
+ * Environments and heuristics report costs as doubles. A search whose records hold another cost type converts them
+ * when they are read, and converts its own costs back when reporting them, all through CostTraits<cost>.
+ *
+ * With double costs everything is kept as it is, and costs are compared with the tolerance of FPUtil. With int32_t the
+ * costs are counted in units of the gcd of the edge costs, so every comparison is exact and branch-free and a record
+ * holds four bytes per cost instead of eight. This requires every edge cost to be a multiple of the gcd, as in STP,
+ * pancake and grids with diagonal cost 1.5 (gcd 0.5). Heuristic values are rounded down to a whole unit, which keeps
+ * them admissible and, since edge costs are whole units, consistent.
+ */
+
+#ifndef COSTTYPE_H
+#define COSTTYPE_H
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include "FPUtil.h"
+
+template<class cost>
+struct CostTraits;
+
+template<>
+struct CostTraits<double> {
+    static double Infinity() { return DBL_MAX; }
+
+    static double Edge(double value, double) { return value; }
+
+    static double Heuristic(double value, double) { return value; }
+
+    static double ToDouble(double value, double) { return value; }
+
+    /**
+     * @return The granularity of the costs for the open lists bucketing them, i.e., the gcd
+     */
+    static double Granularity(double gcd) { return gcd; }
+
+    static bool Less(double a, double b) { return fless(a, b); }
+
+    static bool Greater(double a, double b) { return fgreater(a, b); }
+
+    static bool GreaterEq(double a, double b) { return fgreatereq(a, b); }
+
+    static bool Equal(double a, double b) { return fequal(a, b); }
+
+    /**
+     * @return The lower bound (bForward + bBackward) / 2 of BAE*, rounded up to the next multiple of the gcd
+     */
+    static double HalfRoundedUp(double bForward, double bBackward, double gcd) {
+        return ceil(((bForward + bBackward) / 2) / gcd) * gcd;
+    }
+};
+
+/**
+ * Costs in units of the gcd of the edge costs
+ */
+template<>
+struct CostTraits<int32_t> {
+    static int32_t Infinity() { return INT32_MAX; }
+
+    static int32_t Edge(double value, double gcd) { return static_cast<int32_t>(std::lround(value / gcd)); }
+
+    // The tolerance keeps values which are whole units up to rounding errors from losing a unit
+    static int32_t Heuristic(double value, double gcd) {
+        return static_cast<int32_t>(std::floor(value / gcd + TOLERANCE));
+    }
+
+    static double ToDouble(int32_t value, double gcd) { return value == INT32_MAX ? DBL_MAX : value * gcd; }
+
+    static double Granularity(double) { return 1; }
+
+    static bool Less(int32_t a, int32_t b) { return a < b; }
+
+    static bool Greater(int32_t a, int32_t b) { return a > b; }
+
+    static bool GreaterEq(int32_t a, int32_t b) { return a >= b; }
+
+    static bool Equal(int32_t a, int32_t b) { return a == b; }
+
+    static int32_t HalfRoundedUp(int32_t bForward, int32_t bBackward, double) {
+        return static_cast<int32_t>((static_cast<int64_t>(bForward) + bBackward + 1) / 2);
+    }
+};
+
+#endif //COSTTYPE_H
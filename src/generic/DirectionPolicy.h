@@ -0,0 +1,210 @@
+/**
+ * @file DirectionPolicy.h
+ * @package hog2
+ * @brief Direction-choosing policies for bidirectional searches
+ *
+ * A bidirectional search takes a policy as a template argument, and before every expansion asks it which side to
+ * expand through ExpandForward(sides). The sides object is provided by the search and has these const functions, all
+ * taking whether they are asked about the forward side:
+ * - OpenSize(bool forward): number of nodes the side can expand next, of an integral type of the search's choice
+ * - double TopB(bool forward), TopF(bool forward), TopG(bool forward): b, f and g of the next node of the side, DBL_MAX
+ *   if there is none
+ * - uint64_t Expansions(bool forward): number of expansions done on the side so far
+ * - uint64_t Generated(): number of successors generated so far by both sides
+ * Since the policy is known at compile time, the choice is inlined into the search loop, and only the values the policy
+ * reads are computed. A new policy is a small class with Reset, ExpandForward, AppendCounters and kUsesOpenSizes.
+ */
+
+#ifndef DIRECTIONPOLICY_H
+#define DIRECTIONPOLICY_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * Alternates between the directions, starting with the forward one. This is the original BAE* definition.
+ */
+class AlternatingDirection {
+public:
+    // Whether the policy reads OpenSize, which some searches have to count specifically for it
+    static const bool kUsesOpenSizes = false;
+
+    void Reset() { forward = true; }
+
+    /**
+     * Appends the "key: value; " counters of the policy to the report of a run
+     */
+    void AppendCounters(std::string &) const {}
+
+    template<class sides>
+    bool ExpandForward(const sides &) {
+        bool current = forward;
+        forward = !forward;
+        return current;
+    }
+
+private:
+    bool forward = true;
+};
+
+/**
+ * Expands the side with fewer open nodes, forward on ties. This is the BS* policy, roughly Pohl's cardinality criterion.
+ */
+class CardinalityDirection {
+public:
+    static const bool kUsesOpenSizes = true;
+
+    void Reset() {}
+
+    void AppendCounters(std::string &) const {}
+
+    template<class sides>
+    bool ExpandForward(const sides &s) { return s.OpenSize(true) <= s.OpenSize(false); }
+};
+
+/**
+ * How BFDDirection breaks ties between sides with the same b-value
+ */
+enum class BFDTieBreak {
+    Alternate, // Alternate between the directions, counting only the ties
+    Forward,
+    Backward
+};
+
+/**
+ * Best-first direction: expands the side whose next node has the lowest b-value
+ */
+template<BFDTieBreak tieBreak = BFDTieBreak::Alternate>
+class BFDDirection {
+public:
+    static const bool kUsesOpenSizes = false;
+
+    void Reset() { forward = true; }
+
+    void AppendCounters(std::string &) const {}
+
+    template<class sides>
+    bool ExpandForward(const sides &s) {
+        double bF = s.TopB(true);
+        double bB = s.TopB(false);
+        if (bF < bB)
+            return true;
+        if (bF > bB)
+            return false;
+        if (tieBreak == BFDTieBreak::Forward)
+            return true;
+        if (tieBreak == BFDTieBreak::Backward)
+            return false;
+        bool current = forward;
+        forward = !forward;
+        return current;
+    }
+
+private:
+    bool forward = true;
+};
+
+/**
+ * Expands the side whose b-best node, the one it would expand next, has the lower f-cost. The searches order their open
+ * lists by b, so this is not the lowest f-cost of the side's open list. Ties go to the side with fewer open nodes.
+ */
+class BestBoundDirection {
+public:
+    static const bool kUsesOpenSizes = true;
+
+    void Reset() {}
+
+    void AppendCounters(std::string &) const {}
+
+    template<class sides>
+    bool ExpandForward(const sides &s) {
+        double fF = s.TopF(true);
+        double fB = s.TopF(false);
+        if (fF != fB)
+            return fF < fB;
+        return s.OpenSize(true) <= s.OpenSize(false);
+    }
+};
+
+/**
+ * Expands the side with the lower expected work. On asymmetric domains the expansions of the two sides differ in
+ * branching factor and in the cost of generating successors and computing heuristics, which counting nodes ignores.
+ * The wall-clock time and the number of successors of an expansion are measured between consecutive calls, and kept as
+ * exponential moving averages per side. The expected work of a side before the bound rises is estimated as its number
+ * of open nodes times its average expansion time. The time of an expansion already includes generating its successors
+ * and computing their heuristics, so the number of successors is only reported. The policy alternates until both
+ * sides were measured.
+ */
+class ExpansionCostDirection {
+public:
+    static const bool kUsesOpenSizes = true;
+
+    void Reset() {
+        for (int side = 0; side < 2; ++side) {
+            expansions[side] = 0;
+            averageTime[side] = averageGenerated[side] = 0;
+        }
+        lastSide = -1;
+    }
+
+    /**
+     * Appends the expansions of each side, their average time in microseconds and their average number of successors
+     */
+    void AppendCounters(std::string &out) const {
+        char buffer[160];
+        snprintf(buffer, sizeof(buffer), "fexp: %llu; bexp: %llu; fus: %1.3f; bus: %1.3f; fgen: %1.2f; bgen: %1.2f; ",
+                 (unsigned long long) expansions[0], (unsigned long long) expansions[1], averageTime[0] * 1e6,
+                 averageTime[1] * 1e6, averageGenerated[0], averageGenerated[1]);
+        out += buffer;
+    }
+
+    template<class sides>
+    bool ExpandForward(const sides &s) {
+        clock::time_point now = clock::now();
+        uint64_t generated = s.Generated();
+        // The time since the last call is the cost of the expansion chosen by it
+        if (lastSide >= 0) {
+            double time = std::chrono::duration<double>(now - lastTime).count();
+            Update(lastSide, time, static_cast<double>(generated - lastGenerated));
+        }
+
+        bool forward;
+        if (expansions[0] == 0 || expansions[1] == 0)
+            forward = expansions[0] <= expansions[1];
+        else
+            forward = s.OpenSize(true) * averageTime[0] <= s.OpenSize(false) * averageTime[1];
+
+        lastSide = forward ? 0 : 1;
+        lastTime = now;
+        lastGenerated = generated;
+        return forward;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    // Weight of the latest expansion in the moving averages
+    static constexpr double kSmoothing = 1.0 / 64;
+
+    void Update(int side, double time, double generated) {
+        if (expansions[side] == 0) {
+            averageTime[side] = time;
+            averageGenerated[side] = generated;
+        } else {
+            averageTime[side] += kSmoothing * (time - averageTime[side]);
+            averageGenerated[side] += kSmoothing * (generated - averageGenerated[side]);
+        }
+        expansions[side]++;
+    }
+
+    uint64_t expansions[2] = {0, 0}; // Measured expansions of the forward and backward sides
+    double averageTime[2] = {0, 0}; // Seconds per expansion
+    double averageGenerated[2] = {0, 0}; // Successors per expansion
+    int lastSide = -1; // Side of the expansion in progress, -1 before the first one
+    clock::time_point lastTime;
+    uint64_t lastGenerated = 0;
+};
+
+#endif //DIRECTIONPOLICY_H
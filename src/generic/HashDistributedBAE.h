@@ -0,0 +1,669 @@
+/**
+ * @file HashDistributedBAE.h
+ * @package hog2
+ * @brief BAE* with each direction spread over several threads by the hash of the states, as in HDA*
+ *
+ * Every direction runs on N workers, and every state is owned by a single worker of each direction, chosen by its hash.
+ * A worker expands its own open list by b-value as in BAE, and sends every successor to the worker that owns it, which
+ * then does the duplicate detection, the heuristic computations and the insertion into its own open/closed list.
+ * Successors are sent in batches through lock-free SharedMailboxes, whose batches are recycled. Every worker indexes its
+ * open/closed list in a BDPublishedIndex only it writes. The same worker index owns a state in both directions, so the
+ * two workers owning a state meet, as in ParallelBAE, by reading the g-cost and the closed flag from the index of each
+ * other without locks.
+ *
+ * A worker only expands nodes whose b-value is not above the lowest b-value of its direction, as last read from all
+ * the workers, so the workers of a direction expand the same b-layer together, and wait for each other between layers.
+ * Nodes are still not expanded in order of b-value across the whole direction, so a state may be reached again with a
+ * lower g-cost after it was closed, and is then reopened. The parent of a node is kept as the hash of the parent state,
+ * which may be owned by another worker. A worker with nothing to do backs off, from short spins to short sleeps, so that
+ * idle workers leave the cores to busy ones.
+ *
+ * The termination bound needs the lowest b-value of each direction, over the open lists and the successors still on
+ * their way to their owners. Each worker publishes a bound which is never above the b-values of its open nodes, nor
+ * above those of the successors it sent which were not yet received: it only raises the bound once its own batches were
+ * all received, and lowers it as soon as it receives a node with a lower b-value, before acknowledging it. With a
+ * consistent heuristic no successor has a lower b-value than its parent, so the lowest b-value of a direction never
+ * decreases. A reduction reads the bounds of all the workers between two readings of their versions, and only uses
+ * them if no version changed; the lowest of such a reading is then a valid lower bound for its direction. The search ends when a
+ * reduction finds currentCost <= lowerBound.
+ *
+ * The environment and the heuristics are queried by all threads at once, so their const functions must be safe to
+ * call concurrently. This holds for the pancake (without action pruning), sliding-tile and grid environments.
+ */
+
+#ifndef HASHDISTRIBUTEDBAE_H
+#define HASHDISTRIBUTEDBAE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BAE.h"
+#include "BDPublishedIndex.h"
+#include "BDSharedOpenClosed.h"
+#include "BoundStatistics.h"
+#include "FPUtil.h"
+#include "Heuristic.h"
+#include "SearchLimits.h"
+#include "SharedMailbox.h"
+
+template<class state, class action, class environment>
+class HashDistributedBAE {
+public:
+    /**
+     * @param epsilon_ Cost of the least-cost edge
+     * @param gcd_ Greatest common denominator between all edges
+     * @param workers_ Number of threads per direction
+     */
+    HashDistributedBAE(double epsilon_ = 1.0, double gcd_ = 1.0, int workers_ = 2)
+            : env(0), epsilon(epsilon_), gcd(gcd_), numWorkers(std::max(workers_, 1)), currentCost(DBL_MAX) {
+        for (int side = 0; side < 2; ++side) {
+            for (int i = 0; i < numWorkers; ++i) {
+                workers[side].emplace_back(new Worker);
+                workers[side].back()->queue.SetIndex(&workers[side].back()->index, side);
+                workers[side].back()->outbox.resize(numWorkers);
+            }
+        }
+        ResetNodeCount();
+    }
+
+    virtual ~HashDistributedBAE() {}
+
+    void GetPath(environment *env, const state &from, const state &to,
+                 Heuristic<state> *forward, Heuristic<state> *backward, std::vector<state> &thePath);
+
+    virtual const char *GetName() { return "HashDistributedBAE"; }
+
+    void ResetNodeCount() {
+        for (auto &side: workers) {
+            for (auto &worker: side)
+                worker->nodesExpanded = worker->nodesTouched = worker->uniqueNodesExpanded = 0;
+        }
+    }
+
+    uint64_t GetNodesExpanded() const { return Expansions(0) + Expansions(1); }
+
+    uint64_t GetUniqueNodesExpanded() const {
+        return Sum([](const Worker &worker) { return worker.uniqueNodesExpanded; });
+    }
+
+    uint64_t GetNodesTouched() const { return Sum([](const Worker &worker) { return worker.nodesTouched; }); }
+
+    /**
+     * @return The number of expansions done while the lower bound seen by their worker was below the solution cost
+     */
+    uint64_t GetNecessaryExpansions() const {
+        double cost = currentCost;
+        return Sum([cost](const Worker &worker) { return worker.boundStatistics.CountBelow(cost); });
+    }
+
+    /**
+     * @return The number of closed nodes with f-cost above cstar
+     */
+    int GetNumOfExpandedWithFGreaterC(float cstar) const {
+        return static_cast<int>(Sum([cstar](const Worker &worker) { return worker.fCostStatistics.CountAbove(cstar); }));
+    }
+
+    /**
+     * Appends the number of workers, the expansions of each direction and the largest processor time of its workers to
+     * the report of a run. With a core per worker, the time of the search is about the larger of the two times.
+     */
+    void AppendCounters(std::string &out) const {
+        char buffer[160];
+        snprintf(buffer, sizeof(buffer), "workers: %d; fexp: %llu; bexp: %llu; fcpu: %1.6fs; bcpu: %1.6fs; ",
+                 numWorkers, (unsigned long long) Expansions(0), (unsigned long long) Expansions(1), CPUTime(0),
+                 CPUTime(1));
+        out += buffer;
+    }
+
+    /**
+     * Sets the resource budgets used by every following search. The expansion budget is shared by all the workers.
+     */
+    void SetLimits(const SearchLimits &limits) { limiter.SetLimits(limits); }
+
+    SearchStatus GetSearchStatus() const { return limiter.GetStatus(); }
+
+    /**
+     * @return The best lower bound proven by the last search, which is the solution cost if it was solved
+     */
+    double GetBestLowerBound() const {
+        if (limiter.Solved())
+            return currentCost;
+        double bound = 0;
+        for (auto &side: workers) {
+            for (auto &worker: side)
+                bound = std::max(bound, worker->bestLowerBound);
+        }
+        return bound;
+    }
+
+    /**
+     * @return The cost of the best solution found by the last search, DBL_MAX if none was found
+     */
+    double GetBestUpperBound() const { return currentCost; }
+
+private:
+    typedef BDSharedOpenClosed<state, BAECompare<state>, BAEOpenClosedData<state>, BDPublishedIndex> openClosed;
+
+    /**
+     * A successor on its way to the worker owning it
+     */
+    struct Message {
+        state s;
+        uint64_t hash;
+        uint64_t parentHash;
+        double g;
+    };
+
+    // A batch is sent once it has this many successors
+    static const size_t kBatchSize = 64;
+    // Expansions between sending all the batches, however small, so that other workers do not wait for them
+    static const int kFlushInterval = 16;
+    // Expansions between two checks of the termination bound and the limits
+    static const int kReduceInterval = 32;
+    // Idle rounds spinning, with twice as many pauses each round, then yielding, before an idle worker sleeps
+    static const int kSpinRounds = 6;
+    static const int kYieldRounds = 16;
+    // Longest sleep of an idle worker, short enough not to delay the next b-layer much
+    static const int kMaxSleepMicroseconds = 50;
+
+    /**
+     * Everything owned by a single worker. Other threads only send to its mailbox, return its batches to its pool,
+     * acknowledge its batches through pending, and read its index, minB, version and nodesExpanded.
+     */
+    struct Worker {
+        BDPublishedIndex index; // The states owned by the worker, with their g-costs and closed flags
+        openClosed queue; // Only the states owned by the worker
+        std::vector<state> neighbors;
+        std::vector<std::vector<Message>> outbox; // Successors not sent yet, by the worker owning them
+        SharedMailbox<Message> mailbox;
+        typename SharedMailbox<Message>::Pool batches; // The batches the worker sends
+        std::atomic<int> pending; // Batches sent and not yet received
+        std::atomic<double> minB; // Published bound on the b-values of the open nodes and of the pending successors
+        std::atomic<uint64_t> version; // Incremented after every change of minB
+        std::atomic<uint64_t> nodesExpanded;
+        uint64_t nodesTouched, uniqueNodesExpanded;
+        int sinceFlush, sinceReduce;
+        int idle; // Rounds without an expansion since the last one
+        double cpuTime; // Processor time of the worker in the last search
+        double bounds[2]; // Lowest b-values of the directions in the last consistent reading of the worker
+        double lowerBound; // Last lower bound seen by the worker
+        double bestLowerBound; // Highest lower bound seen by the worker
+        BoundHistogram boundStatistics;
+        FCostHistogram fCostStatistics;
+        SearchLimiter limiter;
+    };
+
+    void Run(int side, int index);
+
+    bool Expand(int side, int index);
+
+    void Route(int side, int index, const state &s, uint64_t parentHash, double g);
+
+    void Receive(int side, Worker &worker, const Message &message);
+
+    void Flush(int side, int index);
+
+    bool Reduce(Worker &worker);
+
+    bool ReadBounds(double bounds[2]) const;
+
+    void Meet(int side, uint64_t hash, double g, const state &s);
+
+    void Backoff(Worker &worker);
+
+    void Finish(SearchStatus status);
+
+    int OwnerOf(uint64_t hash) const {
+        return static_cast<int>(((hash * 0x9E3779B97F4A7C15ull) >> 32) % static_cast<uint64_t>(numWorkers));
+    }
+
+    double TopB(const Worker &worker) const {
+        return worker.queue.OpenSize() == 0 ? DBL_MAX : worker.queue.Lookat(worker.queue.Peek()).h;
+    }
+
+    /**
+     * Lowers the published bound of the worker if a node with the given b-value was added to its open list
+     */
+    void LowerBound(Worker &worker, double b) {
+        if (b < worker.minB.load(std::memory_order_relaxed)) {
+            worker.minB = b;
+            worker.version++;
+        }
+    }
+
+    /**
+     * Raises the published bound of the worker to the top of its open list, unless some of its successors are still on
+     * their way, whose b-values may be lower
+     */
+    void RaiseBound(Worker &worker) {
+        if (worker.pending.load() != 0)
+            return;
+        for (auto &batch: worker.outbox) {
+            if (!batch.empty())
+                return;
+        }
+        double b = TopB(worker);
+        if (b != worker.minB.load(std::memory_order_relaxed)) {
+            worker.minB = b;
+            worker.version++;
+        }
+    }
+
+    uint64_t Expansions(int side) const {
+        uint64_t sum = 0;
+        for (auto &worker: workers[side])
+            sum += worker->nodesExpanded.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    double CPUTime(int side) const {
+        double time = 0;
+        for (auto &worker: workers[side])
+            time = std::max(time, worker->cpuTime);
+        return time;
+    }
+
+    template<class function>
+    uint64_t Sum(function count) const {
+        uint64_t sum = 0;
+        for (auto &side: workers) {
+            for (auto &worker: side)
+                sum += count(*worker);
+        }
+        return sum;
+    }
+
+    void ExtractPath(int side, const state &node, std::vector<state> &thePath) {
+        uint64_t hash = env->GetStateHash(node);
+        while (true) {
+            const openClosed &queue = workers[side][OwnerOf(hash)]->queue;
+            uint64_t id = 0;
+            queue.Lookup(hash, id);
+            thePath.push_back(queue.Lookat(id).data);
+            // The parent of a root is itself
+            if (queue.Lookat(id).parentID == hash)
+                break;
+            hash = queue.Lookat(id).parentID;
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers[2]; // Forward and backward
+    environment *env;
+    double epsilon; // Cost of the least-cost edge
+    double gcd; // Greatest common denominator between all edges
+    int numWorkers; // Per direction
+    Heuristic<state> *heuristics[2]; // Towards the target of each direction
+    state targets[2]; // The goal for the forward direction, the start for the backward one
+
+    std::atomic<double> currentCost; // Cost of the best solution found so far
+    std::mutex solutionLock; // Guards middleNode, and the updates of currentCost
+    state middleNode; // Meeting point of the current solution
+
+    std::atomic<bool> done; // Set by the first worker to finish, which stops all the others
+    SearchLimiter limiter; // Only holds the limits and the status of the whole search
+};
+
+/**
+ * Given a start and a goal, find a path between them. The first forward worker runs on the calling thread, all the
+ * others on new threads.
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::GetPath(environment *env_, const state &from, const state &to,
+                                                             Heuristic<state> *forward, Heuristic<state> *backward,
+                                                             std::vector<state> &thePath) {
+    env = env_;
+    thePath.resize(0);
+    currentCost = DBL_MAX;
+    done = false;
+    limiter.Start();
+    ResetNodeCount();
+    for (auto &side: workers) {
+        for (auto &worker: side)
+            worker->cpuTime = 0;
+    }
+    if (from == to) {
+        currentCost = 0;
+        return;
+    }
+
+    heuristics[0] = forward;
+    heuristics[1] = backward;
+    targets[0] = to;
+    targets[1] = from;
+    for (int side = 0; side < 2; ++side) {
+        for (auto &worker: workers[side]) {
+            worker->index.Reset();
+            worker->queue.Reset();
+            worker->mailbox.Clear();
+            for (auto &batch: worker->outbox)
+                batch.clear();
+            worker->pending = 0;
+            worker->minB = DBL_MAX;
+            worker->version = 0;
+            worker->sinceFlush = worker->sinceReduce = worker->idle = 0;
+            worker->bounds[0] = worker->bounds[1] = 0;
+            worker->lowerBound = worker->bestLowerBound = 0;
+            worker->boundStatistics.Reset(gcd);
+            worker->fCostStatistics.Reset();
+            worker->limiter.SetLimits(limiter.GetLimits());
+            worker->limiter.Start();
+        }
+
+        // The reverse heuristic of a root is its heuristic to itself, i.e., 0
+        const state &root = targets[1 - side];
+        uint64_t hash = env->GetStateHash(root);
+        Worker &owner = *workers[side][OwnerOf(hash)];
+        double h = heuristics[side]->HCost(root, targets[side]);
+        BDPublishedSlot &slot = owner.index.Insert(hash);
+        auto &rootData = owner.queue.Lookup(owner.queue.AddOpenNode(root, slot, 0, h, hash));
+        rootData.hCost = h;
+        rootData.hash = hash;
+        slot.g = 0;
+        owner.minB = h;
+    }
+
+    std::vector<std::thread> threads;
+    for (int side = 0; side < 2; ++side) {
+        for (int i = 0; i < numWorkers; ++i) {
+            if (side != 0 || i != 0)
+                threads.emplace_back(&HashDistributedBAE::Run, this, side, i);
+        }
+    }
+    Run(0, 0);
+    for (auto &thread: threads)
+        thread.join();
+
+    if (!limiter.Solved())
+        return;
+    std::vector<state> pFor, pBack;
+    ExtractPath(1, middleNode, pBack);
+    ExtractPath(0, middleNode, pFor);
+    std::reverse(pFor.begin(), pFor.end());
+    thePath = pFor;
+    thePath.insert(thePath.end(), pBack.begin() + 1, pBack.end());
+}
+
+/**
+ * The loop of a single worker, which runs until one of the workers finishes the search
+ * @param side 0 for the forward search, 1 for the backward search
+ * @param index The index of the worker in its direction
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::Run(int side, int index) {
+    Worker &worker = *workers[side][index];
+    double startTime = ThreadCPUTime();
+    while (!done.load(std::memory_order_relaxed)) {
+        // Every batch is acknowledged only once its nodes are on open and the bound was lowered for them
+        worker.mailbox.Receive([&](const std::vector<Message> &messages, int sender) {
+            for (const Message &message: messages)
+                Receive(side, worker, message);
+            workers[side][sender]->pending--;
+        });
+
+        // A node above the lowest b-value of the direction may be one a serial search would never expand, so the
+        // worker first checks whether the others have caught up, and waits for them if they have not
+        if (TopB(worker) > worker.bounds[side] || ++worker.sinceReduce >= kReduceInterval) {
+            if (Reduce(worker))
+                break;
+        }
+        bool expanded = TopB(worker) <= worker.bounds[side] && Expand(side, index);
+        if (expanded)
+            worker.boundStatistics.Add(worker.lowerBound);
+        if (!expanded || ++worker.sinceFlush >= kFlushInterval)
+            Flush(side, index);
+        RaiseBound(worker);
+        if (expanded)
+            worker.idle = 0;
+        else
+            Backoff(worker);
+    }
+    worker.cpuTime = ThreadCPUTime() - startTime;
+}
+
+/**
+ * Expands a single node of the worker, skipping the nodes already closed by the other direction, and routes its
+ * successors to their owners
+ * @return Whether a node was expanded
+ */
+template<class state, class action, class environment>
+bool HashDistributedBAE<state, action, environment>::Expand(int side, int index) {
+    Worker &worker = *workers[side][index];
+    // The same worker index owns the state in the other direction
+    const BDPublishedIndex &otherIndex = workers[1 - side][index]->index;
+    openClosed &current = worker.queue;
+    uint64_t nextID;
+    uint64_t hash = 0;
+    bool success = false;
+    while (current.OpenSize() > 0) {
+        nextID = current.Close();
+        worker.fCostStatistics.Add(current.Lookup(nextID).g + current.Lookup(nextID).hCost);
+        hash = current.Lookup(nextID).hash;
+        // The other direction is checked before the node is marked closed, as in ParallelBAE
+        if (otherIndex.SharedClosed(hash))
+            continue;
+        worker.index.Find(hash)->closed.store(true, std::memory_order_relaxed);
+        success = true;
+        break;
+    }
+    if (!success)
+        return false;
+
+    worker.nodesExpanded.store(worker.nodesExpanded.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (current.Lookup(nextID).reopened == false)
+        worker.uniqueNodesExpanded++;
+
+    // The neighbors are copied out of the open list, which receiving a successor of this worker may grow
+    const state parent = current.Lookup(nextID).data;
+    double g = current.Lookup(nextID).g;
+    env->GetSuccessors(parent, worker.neighbors);
+    for (auto &succ: worker.neighbors) {
+        worker.nodesTouched++;
+        Route(side, index, succ, hash, g + env->GCost(parent, succ));
+    }
+    return true;
+}
+
+/**
+ * Hands a successor to the worker owning it: directly if it is this worker, otherwise through its batch
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::Route(int side, int index, const state &s, uint64_t parentHash,
+                                                           double g) {
+    uint64_t hash = env->GetStateHash(s);
+    int owner = OwnerOf(hash);
+    Worker &worker = *workers[side][index];
+    if (owner == index) {
+        Receive(side, worker, Message{s, hash, parentHash, g});
+        return;
+    }
+    std::vector<Message> &batch = worker.outbox[owner];
+    batch.push_back(Message{s, hash, parentHash, g});
+    if (batch.size() >= kBatchSize) {
+        worker.pending++;
+        workers[side][owner]->mailbox.Send(batch, index, worker.batches);
+    }
+}
+
+/**
+ * Adds a successor to the open list of the worker owning it, or updates it if it was reached with a lower g-cost
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::Receive(int side, Worker &worker, const Message &message) {
+    openClosed &current = worker.queue;
+    uint64_t childID = 0;
+    BDPublishedSlot *slot = worker.index.Find(message.hash);
+    auto loc = current.Lookup(slot, childID);
+    double cost = currentCost.load(std::memory_order_relaxed);
+
+    if (loc == kNotFound) {
+        double h = heuristics[side]->HCost(message.s, targets[side]);
+        double hBounded = std::max(h, epsilon);
+        // Ignore nodes that don't have lower f-cost than the incumbent solution
+        if (!fless(message.g + hBounded, cost))
+            return;
+
+        double rh = heuristics[1 - side]->HCost(message.s, targets[1 - side]);
+        double totalError = (2 * message.g) + hBounded - rh;
+        if (slot == nullptr)
+            slot = &worker.index.Insert(message.hash);
+        auto &newData = current.Lookup(current.AddOpenNode(message.s, *slot, message.g, totalError,
+                                                           message.parentHash));
+        newData.hCost = h;
+        newData.rhCost = rh;
+        newData.hash = message.hash;
+        LowerBound(worker, totalError);
+        slot->g = message.g;
+        Meet(side, message.hash, message.g, message.s);
+        return;
+    }
+
+    auto &childData = current.Lookup(childID);
+    if (!fless(message.g, childData.g) || fgreatereq(message.g + childData.hCost, cost))
+        return;
+    // Nodes are not expanded in global b order, so a closed node may have been reached through a longer path
+    if (loc == kClosedList) {
+        worker.fCostStatistics.Remove(childData.g + childData.hCost);
+        current.Reopen(childID);
+    }
+    double gDiff = childData.g - message.g;
+    childData.parentID = message.parentHash;
+    childData.g = message.g;
+    childData.h = childData.h - (2 * gDiff);
+    current.KeyChanged(childID);
+    LowerBound(worker, childData.h);
+    slot->g = message.g;
+    Meet(side, message.hash, message.g, message.s);
+}
+
+/**
+ * Sends every batch of the worker which is not empty
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::Flush(int side, int index) {
+    Worker &worker = *workers[side][index];
+    worker.sinceFlush = 0;
+    for (int owner = 0; owner < numWorkers; ++owner) {
+        if (worker.outbox[owner].empty())
+            continue;
+        worker.pending++;
+        workers[side][owner]->mailbox.Send(worker.outbox[owner], index, worker.batches);
+    }
+}
+
+/**
+ * Checks the limits and the termination bound, and updates the bounds seen by the worker
+ * @return Whether the search ended
+ */
+template<class state, class action, class environment>
+bool HashDistributedBAE<state, action, environment>::Reduce(Worker &worker) {
+    worker.sinceReduce = 0;
+    if (worker.limiter.Exceeded(GetNodesExpanded())) {
+        Finish(worker.limiter.GetStatus());
+        return true;
+    }
+
+    double bounds[2];
+    if (!ReadBounds(bounds))
+        return false;
+    worker.bounds[0] = bounds[0];
+    worker.bounds[1] = bounds[1];
+    // The incumbent only decreases, so reading it after the bounds is safe
+    double cost = currentCost.load();
+    double lowerBound = DBL_MAX;
+    if (bounds[0] != DBL_MAX && bounds[1] != DBL_MAX)
+        lowerBound = ceil(((bounds[0] + bounds[1]) / 2) / gcd) * gcd;
+    else if (cost == DBL_MAX) {
+        // A direction has nothing left to expand and nothing on its way
+        Finish(SearchStatus::Unsolvable);
+        return true;
+    }
+    if (cost <= lowerBound) {
+        Finish(SearchStatus::Solved);
+        return true;
+    }
+    worker.lowerBound = lowerBound;
+    worker.bestLowerBound = std::max(worker.bestLowerBound, lowerBound);
+    return false;
+}
+
+/**
+ * Reads the lowest published bound of each direction
+ * @return Whether the reading is consistent, i.e., no bound changed while it was read
+ */
+template<class state, class action, class environment>
+bool HashDistributedBAE<state, action, environment>::ReadBounds(double bounds[2]) const {
+    uint64_t versions = 0;
+    for (auto &side: workers) {
+        for (auto &worker: side)
+            versions += worker->version.load();
+    }
+    for (int side = 0; side < 2; ++side) {
+        bounds[side] = DBL_MAX;
+        for (auto &worker: workers[side])
+            bounds[side] = std::min(bounds[side], worker->minB.load());
+    }
+    // Versions only grow, so their sum is the same only if none of them changed
+    uint64_t check = 0;
+    for (auto &side: workers) {
+        for (auto &worker: side)
+            check += worker->version.load();
+    }
+    return check == versions;
+}
+
+/**
+ * Checks whether a state whose g-cost the given direction just published meets the other direction with a better
+ * solution. Both workers owning the state publish before they check, so if they reach it at the same time at least one
+ * of them sees the g-cost of the other.
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::Meet(int side, uint64_t hash, double g, const state &s) {
+    double otherG = workers[1 - side][OwnerOf(hash)]->index.SharedG(hash);
+    if (otherG == DBL_MAX || !fless(g + otherG, currentCost.load()))
+        return;
+    std::lock_guard<std::mutex> guard(solutionLock);
+    if (fless(g + otherG, currentCost.load())) {
+        middleNode = s;
+        currentCost = g + otherG;
+    }
+}
+
+/**
+ * Waits a little before the next round of an idle worker, longer the longer it has been idle: first by spinning, which
+ * keeps the worker ready for the next batch, then by yielding, then by sleeping, with a bounded sleep
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::Backoff(Worker &worker) {
+    int round = worker.idle++;
+    if (round < kSpinRounds) {
+        for (int i = 0; i < (1 << round); ++i) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+    } else if (round < kYieldRounds)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(
+                std::min(1 << std::min(round - kYieldRounds, 16), kMaxSleepMicroseconds)));
+}
+
+/**
+ * Ends the search with the given status, unless another worker ended it first
+ */
+template<class state, class action, class environment>
+void HashDistributedBAE<state, action, environment>::Finish(SearchStatus status) {
+    bool expected = false;
+    if (done.compare_exchange_strong(expected, true))
+        limiter.Stop(status);
+}
+
+#endif //HASHDISTRIBUTEDBAE_H
@@ -0,0 +1,406 @@
+/**
+ * @file ParallelBAE.h
+ * @package hog2
+ * @brief BAE* with the forward and backward searches running concurrently on two threads
+ *
+ * Between collisions the two frontiers of BAE* are independent, so each direction runs on its own thread with its own
+ * open/closed list, expanding by b-value as in BAE. The threads only share:
+ * - The index of each direction (BDPublishedIndex), which only its own thread writes. It holds the records of the
+ *   direction, so a successor is looked up with a single probe of it, as in BAE. The other thread reads from it,
+ *   without locks, the g-cost of a state and whether it was closed.
+ * - The incumbent solution cost, published atomically, and the meeting node, guarded by a mutex taken only when a
+ *   better solution is found.
+ * - The b-value of the top of each open list, published atomically after every expansion.
+ *
+ * A thread publishes the g-cost of a state only when it adds the state or improves its g-cost, and only then reads the
+ * g-cost of the other direction to check for a better solution. A popped node is skipped if the other direction
+ * closed it. Two threads popping the same state at once may both expand it, but never both skip it.
+ *
+ * With a consistent heuristic the b-value of a successor is never lower than that of its parent, so the smallest
+ * b-value on open never decreases. A b-value published by the other thread is therefore never above its current one,
+ * and a lower bound computed from it is always valid, merely less tight. The search ends as soon as one of the threads
+ * sees currentCost <= lowerBound, as in BAE.
+ *
+ * The environment and the heuristics are queried by both threads at once, so their const functions must be safe to
+ * call concurrently. This holds for the pancake (without action pruning), sliding-tile and grid environments.
+ */
+
+#ifndef PARALLELBAE_H
+#define PARALLELBAE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AStarOpenClosed.h"
+#include "BAE.h"
+#include "BDPublishedIndex.h"
+#include "BDSharedOpenClosed.h"
+#include "BoundStatistics.h"
+#include "FPUtil.h"
+#include "Heuristic.h"
+#include "SearchLimits.h"
+
+template<class state, class action, class environment>
+class ParallelBAE {
+public:
+    /**
+     * @param epsilon_ Cost of the least-cost edge
+     * @param gcd_ Greatest common denominator between all edges
+     */
+    ParallelBAE(double epsilon_ = 1.0, double gcd_ = 1.0) : env(0), epsilon(epsilon_), gcd(gcd_), currentCost(DBL_MAX) {
+        ResetNodeCount();
+        sides[0].queue.SetIndex(&sides[0].index, 0);
+        sides[1].queue.SetIndex(&sides[1].index, 1);
+    }
+
+    virtual ~ParallelBAE() {}
+
+    void GetPath(environment *env, const state &from, const state &to,
+                 Heuristic<state> *forward, Heuristic<state> *backward, std::vector<state> &thePath);
+
+    virtual const char *GetName() { return "ParallelBAE"; }
+
+    void ResetNodeCount() {
+        for (auto &side: sides)
+            side.nodesExpanded = side.nodesTouched = side.uniqueNodesExpanded = 0;
+    }
+
+    uint64_t GetNodesExpanded() const { return sides[0].nodesExpanded + sides[1].nodesExpanded; }
+
+    uint64_t GetUniqueNodesExpanded() const { return sides[0].uniqueNodesExpanded + sides[1].uniqueNodesExpanded; }
+
+    uint64_t GetNodesTouched() const { return sides[0].nodesTouched + sides[1].nodesTouched; }
+
+    /**
+     * @return The number of expansions done while the lower bound seen by their thread was below the solution cost
+     */
+    uint64_t GetNecessaryExpansions() const {
+        return sides[0].boundStatistics.CountBelow(currentCost) + sides[1].boundStatistics.CountBelow(currentCost);
+    }
+
+    /**
+     * @return The number of closed nodes with f-cost above cstar
+     */
+    int GetNumOfExpandedWithFGreaterC(float cstar) const {
+        return sides[0].fCostStatistics.CountAbove(cstar) + sides[1].fCostStatistics.CountAbove(cstar);
+    }
+
+    /**
+     * Appends the expansions of each direction and the processor time of its thread to the report of a run. With a
+     * core per thread, the time of the search is about the larger of the two.
+     */
+    void AppendCounters(std::string &out) const {
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), "fexp: %llu; bexp: %llu; fcpu: %1.6fs; bcpu: %1.6fs; ",
+                 (unsigned long long) sides[0].nodesExpanded.load(), (unsigned long long) sides[1].nodesExpanded.load(),
+                 sides[0].cpuTime, sides[1].cpuTime);
+        out += buffer;
+    }
+
+    /**
+     * Sets the resource budgets used by every following search. The expansion budget is shared by both threads.
+     */
+    void SetLimits(const SearchLimits &limits) { limiter.SetLimits(limits); }
+
+    SearchStatus GetSearchStatus() const { return limiter.GetStatus(); }
+
+    /**
+     * @return The best lower bound proven by the last search, which is the solution cost if it was solved
+     */
+    double GetBestLowerBound() const {
+        return limiter.Solved() ? currentCost.load() : std::max(sides[0].bestLowerBound, sides[1].bestLowerBound);
+    }
+
+    /**
+     * @return The cost of the best solution found by the last search, DBL_MAX if none was found
+     */
+    double GetBestUpperBound() const { return currentCost; }
+
+private:
+    typedef BDSharedOpenClosed<state, BAECompare<state>, BAEOpenClosedData<state>, BDPublishedIndex> openClosed;
+
+    /**
+     * Everything owned by the thread of one direction. Only the shared functions of the index, minB and nodesExpanded
+     * are used by the other thread.
+     */
+    struct Side {
+        BDPublishedIndex index;
+        openClosed queue;
+        std::vector<state> neighbors;
+        std::vector<uint64_t> neighborHashes;
+        Heuristic<state> *heuristic; // Towards the target of the direction
+        Heuristic<state> *reverseHeuristic; // Towards the source of the direction
+        state target, source;
+        std::atomic<double> minB; // b-value of the top of the open list, DBL_MAX once it is empty
+        std::atomic<uint64_t> nodesExpanded;
+        uint64_t nodesTouched, uniqueNodesExpanded;
+        double bestLowerBound; // Highest lower bound seen by the thread
+        double cpuTime; // Processor time of the thread in the last search
+        BoundHistogram boundStatistics;
+        FCostHistogram fCostStatistics;
+        SearchLimiter limiter;
+    };
+
+    void Run(int side);
+
+    bool Expand(int side);
+
+    void Meet(int side, uint64_t hash, double g, const state &s);
+
+    void Finish(SearchStatus status);
+
+    double TopB(const Side &side) const {
+        return side.queue.OpenSize() == 0 ? DBL_MAX : side.queue.Lookat(side.queue.Peek()).h;
+    }
+
+    void ExtractPath(const openClosed &queue, const state &node, std::vector<state> &thePath) {
+        uint64_t id = 0;
+        queue.Lookup(env->GetStateHash(node), id);
+        while (queue.Lookat(id).parentID != id) {
+            thePath.push_back(queue.Lookat(id).data);
+            id = queue.Lookat(id).parentID;
+        }
+        thePath.push_back(queue.Lookat(id).data);
+    }
+
+    Side sides[2]; // Forward and backward
+    environment *env;
+    double epsilon; // Cost of the least-cost edge
+    double gcd; // Greatest common denominator between all edges
+
+    std::atomic<double> currentCost; // Cost of the best solution found so far
+    std::mutex solutionLock; // Guards middleNode, and the updates of currentCost
+    state middleNode; // Meeting point of the current solution
+
+    std::atomic<bool> done; // Set by the first thread to finish, which stops the other one
+    SearchLimiter limiter; // Only holds the limits and the status of the whole search
+};
+
+/**
+ * Given a start and a goal, find a path between them. The backward search runs on a new thread, the forward search on
+ * the calling one.
+ */
+template<class state, class action, class environment>
+void ParallelBAE<state, action, environment>::GetPath(environment *env_, const state &from, const state &to,
+                                                      Heuristic<state> *forward, Heuristic<state> *backward,
+                                                      std::vector<state> &thePath) {
+    env = env_;
+    thePath.resize(0);
+    currentCost = DBL_MAX;
+    done = false;
+    limiter.Start();
+    ResetNodeCount();
+    for (auto &side: sides)
+        side.cpuTime = 0;
+    if (from == to) {
+        currentCost = 0;
+        return;
+    }
+
+    sides[0].heuristic = sides[1].reverseHeuristic = forward;
+    sides[1].heuristic = sides[0].reverseHeuristic = backward;
+    sides[0].target = sides[1].source = to;
+    sides[1].target = sides[0].source = from;
+    for (int i = 0; i < 2; ++i) {
+        Side &side = sides[i];
+        side.index.Reset();
+        side.queue.Reset();
+        side.bestLowerBound = 0;
+        side.boundStatistics.Reset(gcd);
+        side.fCostStatistics.Reset();
+        side.limiter.SetLimits(limiter.GetLimits());
+        side.limiter.Start();
+
+        // The reverse heuristic of a root is its heuristic to itself, i.e., 0
+        const state &root = side.source;
+        double h = side.heuristic->HCost(root, side.target);
+        uint64_t hash = env->GetStateHash(root);
+        BDPublishedSlot &slot = side.index.Insert(hash);
+        auto &rootData = side.queue.Lookup(side.queue.AddOpenNode(root, slot, 0, h));
+        rootData.hCost = h;
+        rootData.hash = hash;
+        slot.g = 0;
+        side.minB = h;
+    }
+
+    std::thread backwardThread(&ParallelBAE::Run, this, 1);
+    Run(0);
+    backwardThread.join();
+
+    if (!limiter.Solved())
+        return;
+    std::vector<state> pFor, pBack;
+    ExtractPath(sides[1].queue, middleNode, pBack);
+    ExtractPath(sides[0].queue, middleNode, pFor);
+    std::reverse(pFor.begin(), pFor.end());
+    thePath = pFor;
+    thePath.insert(thePath.end(), pBack.begin() + 1, pBack.end());
+}
+
+/**
+ * The loop of the thread of a single direction, which runs until one of the threads finishes the search
+ * @param side 0 for the forward search, 1 for the backward search
+ */
+template<class state, class action, class environment>
+void ParallelBAE<state, action, environment>::Run(int side) {
+    Side &own = sides[side];
+    const Side &other = sides[1 - side];
+    double startTime = ThreadCPUTime();
+    while (!done.load(std::memory_order_relaxed)) {
+        double cost = currentCost.load();
+        if (own.queue.OpenSize() == 0 && cost == DBL_MAX) {
+            Finish(SearchStatus::Unsolvable);
+            break;
+        }
+
+        // A stale b-value of the other side is lower than its current one, so the bound stays valid
+        double ownB = TopB(own);
+        double otherB = other.minB.load();
+        double lowerBound = DBL_MAX;
+        if (ownB != DBL_MAX && otherB != DBL_MAX)
+            lowerBound = ceil(((ownB + otherB) / 2) / gcd) * gcd;
+        if (cost <= lowerBound) {
+            Finish(SearchStatus::Solved);
+            break;
+        }
+        own.bestLowerBound = std::max(own.bestLowerBound, lowerBound);
+
+        if (own.limiter.Exceeded(own.nodesExpanded + other.nodesExpanded.load(std::memory_order_relaxed))) {
+            Finish(own.limiter.GetStatus());
+            break;
+        }
+
+        if (Expand(side))
+            own.boundStatistics.Add(lowerBound);
+        own.minB = TopB(own);
+    }
+    own.cpuTime = ThreadCPUTime() - startTime;
+}
+
+/**
+ * Expands a single node of the given direction, skipping the nodes already closed by the other direction
+ * @return Whether a node was expanded
+ */
+template<class state, class action, class environment>
+bool ParallelBAE<state, action, environment>::Expand(int side) {
+    Side &own = sides[side];
+    const BDPublishedIndex &otherIndex = sides[1 - side].index;
+    openClosed &current = own.queue;
+    uint64_t nextID;
+    bool success = false;
+    while (current.OpenSize() > 0) {
+        nextID = current.Close();
+        auto &nextData = current.Lookup(nextID);
+        own.fCostStatistics.Add(nextData.g + nextData.hCost);
+        // The other direction is checked before the node is marked closed, so a state popped by both threads at once
+        // is expanded twice rather than skipped by both
+        if (otherIndex.SharedClosed(nextData.hash))
+            continue;
+        own.index.Find(nextData.hash)->closed.store(true, std::memory_order_relaxed);
+        success = true;
+        break;
+    }
+    if (!success)
+        return false;
+
+    own.nodesExpanded.store(own.nodesExpanded.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (current.Lookup(nextID).reopened == false)
+        own.uniqueNodesExpanded++;
+
+    env->GetSuccessors(current.Lookup(nextID).data, own.neighbors);
+    // Hash all the successors first, so the cache misses of their probes overlap
+    own.neighborHashes.resize(own.neighbors.size());
+    for (size_t i = 0; i < own.neighbors.size(); i++) {
+        own.neighborHashes[i] = env->GetStateHash(own.neighbors[i]);
+        own.index.Prefetch(own.neighborHashes[i]);
+    }
+    for (size_t i = 0; i < own.neighbors.size(); i++) {
+        const state &succ = own.neighbors[i];
+        own.nodesTouched++;
+        uint64_t childID = 0;
+        uint64_t hash = own.neighborHashes[i];
+        // Only the index of this direction is probed, the other one only when a g-cost is published
+        BDPublishedSlot *slot = own.index.Find(hash);
+        auto loc = current.Lookup(slot, childID);
+        auto &childData = current.Lookup(childID);
+        auto &parentData = current.Lookup(nextID);
+
+        double edgeCost = env->GCost(parentData.data, succ);
+        double h = loc == kNotFound ? own.heuristic->HCost(succ, own.target) : childData.hCost;
+
+        // ignore states with greater cost than best solution
+        double cost = currentCost.load(std::memory_order_relaxed);
+        if (fgreatereq(parentData.g + edgeCost + h, cost))
+            continue;
+
+        switch (loc) {
+            case kClosedList: // Since BAE* requires a consistent heuristic, this situation should be impossible
+                break;
+            case kOpenList:
+                if (fless(parentData.g + edgeCost, childData.g)) {
+                    childData.parentID = nextID;
+                    double gDiff = childData.g - (parentData.g + edgeCost);
+                    childData.g = parentData.g + edgeCost;
+                    childData.h = childData.h - (2 * gDiff);
+                    current.KeyChanged(childID);
+                    slot->g = childData.g;
+                    Meet(side, hash, childData.g, succ);
+                }
+                break;
+            case kNotFound: {
+                double g = parentData.g + edgeCost;
+                double hBounded = std::max(h, epsilon);
+
+                // Ignore nodes that don't have lower f-cost than the incumbent solution
+                if (!fless(g + hBounded, cost))
+                    break;
+
+                double rh = own.reverseHeuristic->HCost(succ, own.source);
+                double totalError = (2 * g) + hBounded - rh;
+                if (slot == nullptr)
+                    slot = &own.index.Insert(hash);
+                auto &newData = current.Lookup(current.AddOpenNode(succ, *slot, g, totalError, nextID));
+                newData.hCost = h;
+                newData.rhCost = rh;
+                newData.hash = hash;
+                slot->g = g;
+                Meet(side, hash, g, succ);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks whether a state whose g-cost the given direction just published meets the other direction with a better
+ * solution. Both threads publish before they check, so if they reach the state at the same time at least one of them
+ * sees the g-cost of the other.
+ */
+template<class state, class action, class environment>
+void ParallelBAE<state, action, environment>::Meet(int side, uint64_t hash, double g, const state &s) {
+    double otherG = sides[1 - side].index.SharedG(hash);
+    if (otherG == DBL_MAX || !fless(g + otherG, currentCost.load()))
+        return;
+    std::lock_guard<std::mutex> guard(solutionLock);
+    if (fless(g + otherG, currentCost.load())) {
+        middleNode = s;
+        currentCost = g + otherG;
+    }
+}
+
+/**
+ * Ends the search with the given status, unless the other thread ended it first
+ */
+template<class state, class action, class environment>
+void ParallelBAE<state, action, environment>::Finish(SearchStatus status) {
+    bool expected = false;
+    if (done.compare_exchange_strong(expected, true))
+        limiter.Stop(status);
+}
+
+#endif //PARALLELBAE_H
@@ -0,0 +1,193 @@
+/**
+ * @file SearchLimits.h
+ * @package hog2
+ * @brief Per-search resource budgets (expansions, wall time, memory) and the status a search ended with
+ *
+ * A search owns a SearchLimiter, starts it at the beginning of every search and asks it once per expansion whether
+ * it has to stop. The expansion budget costs a single comparison; the clock, the memory usage and the cancel token are
+ * only sampled every few thousand expansions.
+ */
+
+#ifndef SEARCHLIMITS_H
+#define SEARCHLIMITS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * How a search ended
+ */
+enum class SearchStatus {
+    Solved,      // An optimal solution was found (or the start is the goal)
+    Unsolvable,  // The search space was exhausted without connecting the start and the goal
+    NodeLimit,   // Stopped after reaching the expansion budget
+    TimeLimit,   // Stopped after reaching the time budget
+    MemoryLimit, // Stopped after reaching the memory budget
+    Failed,      // Stopped because of an internal inconsistency
+    Cancelled    // Stopped by another thread through its CancelToken
+};
+
+inline const char *SearchStatusName(SearchStatus status) {
+    switch (status) {
+        case SearchStatus::Solved:
+            return "solved";
+        case SearchStatus::Unsolvable:
+            return "unsolvable";
+        case SearchStatus::NodeLimit:
+            return "node-limit";
+        case SearchStatus::TimeLimit:
+            return "time-limit";
+        case SearchStatus::MemoryLimit:
+            return "memory-limit";
+        case SearchStatus::Failed:
+            return "failed";
+        case SearchStatus::Cancelled:
+            return "cancelled";
+    }
+    return "unknown";
+}
+
+/**
+ * @return The processor time used so far by the calling thread, in seconds. The threads of a parallel search report it,
+ * since their wall-clock time also counts the time they waited for a core.
+ */
+inline double ThreadCPUTime() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * Lets any thread stop the searches sharing it, e.g., when several searches race on the same instance and the first
+ * one to finish stops the others. It also records who cancelled it, and when.
+ */
+class CancelToken {
+public:
+    /**
+     * Must not be called while searches use the token
+     */
+    void Reset() { cancelled = false; }
+
+    bool Cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    /**
+     * @param by Who cancels, as reported by CancelledBy
+     * @return Whether this call cancelled the token, i.e., it was not cancelled before
+     */
+    bool Cancel(const std::string &by) {
+        if (cancelled.exchange(true))
+            return false;
+        cancelledBy = by;
+        cancelTime = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    /**
+     * Who cancelled the token, and when. Only safe to read once the thread which cancelled it was joined.
+     */
+    const std::string &CancelledBy() const { return cancelledBy; }
+
+    std::chrono::steady_clock::time_point CancelTime() const { return cancelTime; }
+
+private:
+    std::atomic<bool> cancelled{false};
+    std::string cancelledBy;
+    std::chrono::steady_clock::time_point cancelTime;
+};
+
+/**
+ * Resource budgets of a single search. A value of 0 means no limit.
+ */
+struct SearchLimits {
+    uint64_t maxExpansions = 0;
+    double maxSeconds = 0;
+    uint64_t maxMemoryMB = 0; // Resident memory of the whole process, so it is shared by concurrent searches
+    CancelToken *cancel = nullptr; // The search stops once it is cancelled, if there is one
+};
+
+class SearchLimiter {
+public:
+    void SetLimits(const SearchLimits &limits_) { limits = limits_; }
+
+    const SearchLimits &GetLimits() const { return limits; }
+
+    /**
+     * Starts the clock and resets the status to Solved. Should be called at the beginning of every search.
+     */
+    void Start() {
+        status = SearchStatus::Solved;
+        startTime = std::chrono::steady_clock::now();
+        bool sampled = limits.maxSeconds > 0 || limits.maxMemoryMB > 0 || limits.cancel != nullptr;
+        nextSample = sampled ? kSampleInterval : UINT64_MAX;
+    }
+
+    /**
+     * Checks the limits, should be called before every expansion
+     * @param expansions Number of expansions done so far in the current search
+     * @return Whether the search has to stop; the reason is then given by GetStatus
+     */
+    inline bool Exceeded(uint64_t expansions) {
+        if (limits.maxExpansions != 0 && expansions >= limits.maxExpansions)
+            return Stop(SearchStatus::NodeLimit);
+        if (expansions < nextSample)
+            return false;
+        nextSample = expansions + kSampleInterval;
+        return Sample();
+    }
+
+    /**
+     * Ends the search with the given status
+     * @return Always true, so it can be returned directly from a search step
+     */
+    bool Stop(SearchStatus status_) {
+        status = status_;
+        return true;
+    }
+
+    SearchStatus GetStatus() const { return status; }
+
+    bool Solved() const { return status == SearchStatus::Solved; }
+
+private:
+    static const uint64_t kSampleInterval = 4096;
+
+    bool Sample() {
+        if (limits.cancel != nullptr && limits.cancel->Cancelled())
+            return Stop(SearchStatus::Cancelled);
+        if (limits.maxSeconds > 0) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+            if (elapsed.count() >= limits.maxSeconds)
+                return Stop(SearchStatus::TimeLimit);
+        }
+        if (limits.maxMemoryMB > 0 && ResidentMemoryMB() >= limits.maxMemoryMB)
+            return Stop(SearchStatus::MemoryLimit);
+        return false;
+    }
+
+    /**
+     * @return The resident memory of the process in MB, or 0 if it cannot be read (the limit is then ignored)
+     */
+    static uint64_t ResidentMemoryMB() {
+        FILE *f = fopen("/proc/self/statm", "r");
+        if (f == nullptr)
+            return 0;
+        unsigned long long size = 0, resident = 0;
+        int read = fscanf(f, "%llu %llu", &size, &resident);
+        fclose(f);
+        if (read != 2)
+            return 0;
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+    }
+
+    SearchLimits limits;
+    SearchStatus status = SearchStatus::Solved;
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t nextSample = UINT64_MAX;
+};
+
+#endif //SEARCHLIMITS_H
@@ -0,0 +1,483 @@
+/**
+ * Aggregates the results of the direction driver, replacing the pandas parsing in the analysis/ Python scripts.
+ *
+ * For every domain, all the driver output files under <data>/<domain> are read: the text logs (.out, .txt, .log,
+ * the [D]/[I]/[R] lines) and the binary records written with --results (.bin). Files are mapped into memory and
+ * scanned in place. Only solved runs are kept, and the same checks as the Python scripts are done:
+ * - every instance has a single solution length across all algorithms,
+ * - fabove is 0 for the BFD and TLBAE variants,
+ * - every algorithm was run on the same number of instances.
+ * If all the checks pass, two tables are written to <out>: <domain>.csv with every run, and <domain>_summary.csv with
+ * one row per heuristic, map and algorithm.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <ftw.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "ResultsSink.h"
+
+namespace {
+
+/**
+ * A read-only memory mapping of a whole file
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat sb;
+        if (fstat(fd, &sb) != 0 || sb.st_size == 0)
+            return;
+        void *mem = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED)
+            return;
+        madvise(mem, sb.st_size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mem);
+        size = static_cast<size_t>(sb.st_size);
+    }
+
+    ~MappedFile() {
+        if (data != nullptr)
+            munmap(const_cast<char *>(data), size);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data = nullptr;
+    size_t size = 0;
+
+private:
+    int fd = -1;
+};
+
+/**
+ * A piece of a mapped file
+ */
+struct Span {
+    const char *begin;
+    const char *end;
+
+    size_t size() const { return end - begin; }
+
+    bool operator==(const char *text) const {
+        size_t len = strlen(text);
+        return size() == len && memcmp(begin, text, len) == 0;
+    }
+
+    std::string str() const { return std::string(begin, end); }
+
+    // The numeric fields are short, so they are copied to be null-terminated before parsing
+    double ToDouble() const {
+        char buffer[64];
+        size_t len = std::min(size(), sizeof(buffer) - 1);
+        memcpy(buffer, begin, len);
+        buffer[len] = '\0';
+        return strtod(buffer, nullptr);
+    }
+
+    long long ToInt() const {
+        char buffer[64];
+        size_t len = std::min(size(), sizeof(buffer) - 1);
+        memcpy(buffer, begin, len);
+        buffer[len] = '\0';
+        return strtoll(buffer, nullptr, 10);
+    }
+};
+
+/**
+ * A single solved run
+ */
+struct Row {
+    int heuristic; // Index in Results::heuristics
+    int map; // Index in Results::maps
+    int id;
+    int alg; // Index in Results::algs
+    double solution;
+    uint64_t expanded;
+    int64_t fAbove;
+    double time;
+};
+
+/**
+ * All the runs of a single domain. Heuristic, map and algorithm names are interned, so a row is a few numbers.
+ */
+struct Results {
+    std::vector<std::string> heuristics, maps, algs;
+    std::unordered_map<std::string, int> heuristicIndex, mapIndex, algIndex;
+    std::vector<Row> rows;
+    size_t files = 0, skipped = 0; // skipped counts runs that were not solved
+
+    int Intern(const std::string &name, std::vector<std::string> &names, std::unordered_map<std::string, int> &index) {
+        auto it = index.find(name);
+        if (it != index.end())
+            return it->second;
+        index[name] = static_cast<int>(names.size());
+        names.push_back(name);
+        return static_cast<int>(names.size()) - 1;
+    }
+
+    int Heuristic(const std::string &name) { return Intern(name, heuristics, heuristicIndex); }
+
+    int Map(const std::string &name) { return Intern(name, maps, mapIndex); }
+
+    int Alg(const std::string &name) { return Intern(name, algs, algIndex); }
+};
+
+/**
+ * The map name without its .map extension, as in the grid tables
+ */
+std::string MapName(std::string name) {
+    size_t pos = name.find(".map");
+    if (pos != std::string::npos)
+        name.erase(pos, 4);
+    return name;
+}
+
+/**
+ * The heuristic name of the [D] line of the driver, for the -h argument written in a binary header. The grid driver
+ * has a single heuristic and does not print it.
+ */
+std::string HeuristicName(const std::string &domain, std::string name) {
+    if (domain == "grid")
+        return "";
+    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+    if (domain == "pancake" && !name.empty() && isdigit(static_cast<unsigned char>(name[0])))
+        name = "GAP-" + name;
+    return name;
+}
+
+/**
+ * Calls f(key, value) for every "key: value" item of a "; " separated line
+ */
+template<class F>
+void ForEachItem(const char *begin, const char *end, F f) {
+    while (begin < end) {
+        const char *itemEnd = begin;
+        while (itemEnd < end && !(itemEnd[0] == ';' && itemEnd + 1 < end && itemEnd[1] == ' '))
+            ++itemEnd;
+        const char *colon = begin;
+        while (colon + 1 < itemEnd && !(colon[0] == ':' && colon[1] == ' '))
+            ++colon;
+        if (colon + 1 < itemEnd)
+            f(Span{begin, colon}, Span{colon + 2, itemEnd});
+        begin = itemEnd + 2;
+    }
+}
+
+/**
+ * Parses the [D]/[I]/[R] lines of a driver log. Like the Python scripts, a run inherits the heuristic, map and instance
+ * id of the last [D] and [I] lines before it.
+ */
+void ParseLog(const MappedFile &file, Results &results) {
+    int heuristic = results.Heuristic("");
+    int map = results.Map("");
+    int id = -1;
+    const char *p = file.data, *end = file.data + file.size;
+    while (p < end) {
+        const char *lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+        const char *contentEnd = lineEnd;
+        while (contentEnd > p && (contentEnd[-1] == '\r' || contentEnd[-1] == ' '))
+            --contentEnd;
+
+        if (contentEnd - p > 4 && p[0] == '[' && p[2] == ']' && p[3] == ' ') {
+            char kind = p[1];
+            if (kind == 'D') {
+                heuristic = results.Heuristic("");
+                ForEachItem(p + 4, contentEnd, [&](const Span &key, const Span &value) {
+                    if (key == "heuristic")
+                        heuristic = results.Heuristic(value.str());
+                    else if (key == "map")
+                        map = results.Map(MapName(value.str()));
+                });
+            } else if (kind == 'I') {
+                ForEachItem(p + 4, contentEnd, [&](const Span &key, const Span &value) {
+                    if (key == "id" || key == "ID")
+                        id = static_cast<int>(value.ToInt());
+                });
+            } else if (kind == 'R') {
+                Row row = {heuristic, map, id, -1, -1, 0, 0, 0};
+                bool solved = true;
+                ForEachItem(p + 4, contentEnd, [&](const Span &key, const Span &value) {
+                    if (key == "alg" || key == "algorithm")
+                        row.alg = results.Alg(value.str());
+                    else if (key == "status")
+                        solved = value == "solved";
+                    else if (key == "solution")
+                        row.solution = value.ToDouble();
+                    else if (key == "expanded")
+                        row.expanded = static_cast<uint64_t>(value.ToInt());
+                    else if (key == "fabove")
+                        row.fAbove = value.ToInt();
+                    else if (key == "time")
+                        row.time = value.ToDouble(); // strtod stops at the trailing 's'
+                });
+                if (!solved)
+                    results.skipped++;
+                else if (row.alg >= 0)
+                    results.rows.push_back(row);
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+/**
+ * @return The value of a "key=value" item of the ";" separated header of a binary results file, empty if missing
+ */
+std::string HeaderItem(const std::string &header, const std::string &key) {
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t end = std::min(header.find(';', pos), header.size());
+        if (header.compare(pos, key.size(), key) == 0 && pos + key.size() < end && header[pos + key.size()] == '=')
+            return header.substr(pos + key.size() + 1, end - pos - key.size() - 1);
+        pos = end + 1;
+    }
+    return "";
+}
+
+/**
+ * Parses a binary results file written by ResultsSink
+ */
+void ParseBinary(const MappedFile &file, Results &results, const std::string &path) {
+    const size_t headerStart = sizeof(kBinaryMagic) + sizeof(uint32_t);
+    if (file.size < headerStart || memcmp(file.data, kBinaryMagic, sizeof(kBinaryMagic)) != 0) {
+        std::cerr << "Warning: Not a results file, skipping: " << path << std::endl;
+        return;
+    }
+    uint32_t length;
+    memcpy(&length, file.data + sizeof(kBinaryMagic), sizeof(length));
+    if (file.size < headerStart + length) {
+        std::cerr << "Warning: Truncated results file, skipping: " << path << std::endl;
+        return;
+    }
+    std::string header(file.data + headerStart, length);
+    int heuristic = results.Heuristic(HeuristicName(HeaderItem(header, "domain"), HeaderItem(header, "heuristic")));
+    int map = results.Map(MapName(HeaderItem(header, "map")));
+
+    const char *p = file.data + headerStart + length;
+    size_t count = (file.size - headerStart - length) / sizeof(BinaryRunRecord);
+    for (size_t i = 0; i < count; ++i, p += sizeof(BinaryRunRecord)) {
+        BinaryRunRecord record;
+        memcpy(&record, p, sizeof(record));
+        if (record.status != static_cast<int32_t>(SearchStatus::Solved)) {
+            results.skipped++;
+            continue;
+        }
+        record.alg[sizeof(record.alg) - 1] = '\0';
+        Row row = {heuristic, map, record.id, results.Alg(record.alg), record.solution, record.expanded, record.fAbove,
+                   record.time};
+        results.rows.push_back(row);
+    }
+}
+
+bool HasSuffix(const std::string &s, const char *suffix) {
+    size_t len = strlen(suffix);
+    return s.size() >= len && s.compare(s.size() - len, len, suffix) == 0;
+}
+
+std::vector<std::string> *collectedFiles = nullptr; // nftw takes no user data
+
+int CollectFile(const char *path, const struct stat *, int type, struct FTW *) {
+    if (type == FTW_F)
+        collectedFiles->push_back(path);
+    return 0;
+}
+
+void LoadDomain(const std::string &dir, Results &results) {
+    std::vector<std::string> files;
+    collectedFiles = &files;
+    if (nftw(dir.c_str(), CollectFile, 16, FTW_PHYS) != 0) {
+        std::cerr << "Warning: Cannot read directory: " << dir << std::endl;
+        return;
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto &path: files) {
+        bool log = HasSuffix(path, ".out") || HasSuffix(path, ".txt") || HasSuffix(path, ".log");
+        bool binary = HasSuffix(path, ".bin");
+        if (!log && !binary)
+            continue;
+        MappedFile file(path);
+        if (file.data == nullptr)
+            continue;
+        if (log)
+            ParseLog(file, results);
+        else
+            ParseBinary(file, results, path);
+        results.files++;
+    }
+}
+
+/**
+ * Prints the problems found to stderr
+ * @return Whether all the checks passed
+ */
+bool Verify(const Results &results) {
+    const int kMaxReported = 20;
+    int problems = 0;
+
+    // Single solution length per instance
+    std::map<std::pair<int, int>, double> solutions;
+    for (const auto &row: results.rows) {
+        auto it = solutions.insert({{row.map, row.id}, row.solution}).first;
+        if (it->second != row.solution && problems++ < kMaxReported) {
+            std::cerr << "Inconsistent solution: map " << results.maps[row.map] << " id " << row.id << " "
+                      << results.algs[row.alg] << " found " << row.solution << " instead of " << it->second << "\n";
+        }
+    }
+
+    // No expansions with f above C* for algorithms that guarantee it
+    for (const auto &row: results.rows) {
+        const std::string &alg = results.algs[row.alg];
+        bool guaranteed = alg.compare(0, 7, "BAE-bfd") == 0 || alg.compare(0, 5, "TLBAE") == 0;
+        if (guaranteed && row.fAbove != 0 && problems++ < kMaxReported) {
+            std::cerr << "fabove is not 0: map " << results.maps[row.map] << " id " << row.id << " " << alg
+                      << " fabove " << row.fAbove << "\n";
+        }
+    }
+
+    // Same number of runs for every algorithm
+    std::vector<size_t> counts(results.algs.size(), 0);
+    for (const auto &row: results.rows)
+        counts[row.alg]++;
+    for (size_t a = 1; a < counts.size(); ++a) {
+        if (counts[a] != counts[0] && problems++ < kMaxReported) {
+            std::cerr << "Not all instances were run for all algorithms: " << results.algs[0] << " has " << counts[0]
+                      << " runs, " << results.algs[a] << " has " << counts[a] << "\n";
+        }
+    }
+
+    if (problems > kMaxReported)
+        std::cerr << "... and " << problems - kMaxReported << " more problems\n";
+    return problems == 0;
+}
+
+double Median(std::vector<double> &values) {
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+FILE *OpenTable(const std::string &path) {
+    FILE *f = fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        std::cerr << "Error: Cannot write: " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return f;
+}
+
+void WriteTables(const Results &results, const std::string &domain, const std::string &outDir) {
+    FILE *all = OpenTable(outDir + "/" + domain + ".csv");
+    fprintf(all, "heuristic,map,id,alg,solution,expanded,fabove,time\n");
+    for (const auto &row: results.rows) {
+        fprintf(all, "%s,%s,%d,%s,%.10g,%llu,%lld,%.6f\n", results.heuristics[row.heuristic].c_str(),
+                results.maps[row.map].c_str(), row.id, results.algs[row.alg].c_str(), row.solution,
+                (unsigned long long) row.expanded, (long long) row.fAbove, row.time);
+    }
+    fclose(all);
+
+    // One group per (heuristic, map, algorithm), in the order the names were first seen
+    struct Group {
+        std::vector<double> expanded, times;
+        int64_t fAbove = 0;
+    };
+    std::map<std::tuple<int, int, int>, Group> groups;
+    for (const auto &row: results.rows) {
+        Group &group = groups[std::make_tuple(row.heuristic, row.map, row.alg)];
+        group.expanded.push_back(static_cast<double>(row.expanded));
+        group.times.push_back(row.time);
+        group.fAbove += row.fAbove;
+    }
+    FILE *summary = OpenTable(outDir + "/" + domain + "_summary.csv");
+    fprintf(summary, "heuristic,map,alg,runs,mean_expanded,median_expanded,mean_time,median_time,total_time,"
+                     "total_fabove\n");
+    for (auto &entry: groups) {
+        Group &group = entry.second;
+        double sumExpanded = 0, sumTime = 0;
+        for (double e: group.expanded)
+            sumExpanded += e;
+        for (double t: group.times)
+            sumTime += t;
+        size_t n = group.expanded.size();
+        fprintf(summary, "%s,%s,%s,%zu,%.2f,%.1f,%.6f,%.6f,%.6f,%lld\n",
+                results.heuristics[std::get<0>(entry.first)].c_str(), results.maps[std::get<1>(entry.first)].c_str(),
+                results.algs[std::get<2>(entry.first)].c_str(), n, n ? sumExpanded / n : 0, Median(group.expanded),
+                n ? sumTime / n : 0, Median(group.times), sumTime, (long long) group.fAbove);
+    }
+    fclose(summary);
+}
+
+void Help() {
+    std::cout << "Usage: aggregate [OPTIONS] [DOMAIN...]\n\n";
+    std::cout << "Checks and summarizes the results under <DATA>/<DOMAIN> (default domains: grid stp pancake).\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --data <DIR>                  Directory holding a sub-directory per domain (default data).\n";
+    std::cout << "  --out <DIR>                   Directory the tables are written to (default results).\n";
+    std::cout << "  --help                        Show this help message and exit.\n";
+    std::exit(EXIT_SUCCESS);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string dataDir = "data", outDir = "results";
+    std::vector<std::string> domains;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help") {
+            Help();
+        } else if ((arg == "--data" || arg == "--out") && i + 1 < argc) {
+            (arg == "--data" ? dataDir : outDir) = argv[++i];
+        } else if (arg[0] == '-') {
+            std::cerr << "Error: Unknown argument: " << arg << std::endl;
+            exit(EXIT_FAILURE);
+        } else {
+            domains.push_back(arg);
+        }
+    }
+    if (domains.empty())
+        domains = {"grid", "stp", "pancake"};
+    mkdir(outDir.c_str(), 0755);
+
+    bool ok = true;
+    for (const auto &domain: domains) {
+        std::cout << "---Handling " << domain << " results---" << std::endl;
+        Results results;
+        LoadDomain(dataDir + "/" + domain, results);
+        std::cout << "Loaded " << results.rows.size() << " solved runs from " << results.files << " files";
+        if (results.skipped > 0)
+            std::cout << " (skipped " << results.skipped << " unsolved runs)";
+        std::cout << std::endl;
+        if (!Verify(results)) {
+            std::cerr << "Error: Verification failed for " << domain << ", no tables written" << std::endl;
+            ok = false;
+            continue;
+        }
+        WriteTables(results, domain, outDir);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,397 @@
+#ifndef SRC_PAPER_ALGORITHMREGISTRY_H
+#define SRC_PAPER_ALGORITHMREGISTRY_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Timer.h"
+#include "SearchLimits.h"
+#include "RunOptions.h"
+#include "ResultsSink.h"
+#include "InstanceRunner.h"
+#include "BAE.h"
+#include "BDBucketOpenClosed.h"
+#include "BDDirectIndex.h"
+#include "ParallelBAE.h"
+#include "HashDistributedBAE.h"
+#include "DirectionPolicy.h"
+#include "TwoLevelBAE.h"
+#include "DBBS/DBBS.h"
+
+/**
+ * How the driver reads the results of a finished search. The default fits BAE, other algorithms
+ * specialize it below. Both are only called for searches that were solved.
+ */
+template<class search>
+struct SearchReport {
+    template<class environment, class state>
+    static double SolutionLength(search &alg, environment &env, std::vector<state> &path) {
+        return env.GetPathLength(path);
+    }
+
+    static int FAbove(search &alg, double solLen) { return alg.GetNumOfExpandedWithFGreaterC(solLen); }
+
+    // Extra "key: value; " counters of the [R] line
+    static void AppendCounters(search &alg, std::string &out) { alg.GetDirectionPolicy().AppendCounters(out); }
+};
+
+template<class state, class action, class environment, class statistics, class direction, class fStatistics,
+        class nodeStorage>
+struct SearchReport<TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage>> {
+    typedef TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage> search;
+
+    // TwoLevelBAE does not reconstruct the path, only its cost
+    static double SolutionLength(search &alg, environment &, std::vector<state> &) {
+        return alg.GetSolLen();
+    }
+
+    static int FAbove(search &alg, double solLen) {
+        return alg.GetNumOfExpandedWithFGreaterC(solLen);
+    }
+
+    static void AppendCounters(search &alg, std::string &out) {
+        alg.GetDirectionPolicy().AppendCounters(out);
+    }
+};
+
+template<class state, class action, class environment, MinCriterion criterion, class direction, class priorityQueue>
+struct SearchReport<DBBS<state, action, environment, criterion, direction, priorityQueue>> {
+    static double SolutionLength(DBBS<state, action, environment, criterion, direction, priorityQueue> &,
+                                 environment &env, std::vector<state> &path) {
+        return env.GetPathLength(path);
+    }
+
+    // DBBS never expands a node with f above C*
+    static int FAbove(DBBS<state, action, environment, criterion, direction, priorityQueue> &, double) { return 0; }
+
+    static void AppendCounters(DBBS<state, action, environment, criterion, direction, priorityQueue> &alg,
+                               std::string &out) {
+        alg.GetDirectionPolicy().AppendCounters(out);
+    }
+};
+
+template<class state, class action, class environment>
+struct SearchReport<ParallelBAE<state, action, environment>> {
+    static double SolutionLength(ParallelBAE<state, action, environment> &, environment &env,
+                                 std::vector<state> &path) {
+        return env.GetPathLength(path);
+    }
+
+    static int FAbove(ParallelBAE<state, action, environment> &alg, double solLen) {
+        return alg.GetNumOfExpandedWithFGreaterC(solLen);
+    }
+
+    // Both directions run at once, so there is no direction policy, only the expansions of each thread
+    static void AppendCounters(ParallelBAE<state, action, environment> &alg, std::string &out) {
+        alg.AppendCounters(out);
+    }
+};
+
+template<class state, class action, class environment>
+struct SearchReport<HashDistributedBAE<state, action, environment>> {
+    static double SolutionLength(HashDistributedBAE<state, action, environment> &, environment &env,
+                                 std::vector<state> &path) {
+        return env.GetPathLength(path);
+    }
+
+    static int FAbove(HashDistributedBAE<state, action, environment> &alg, double solLen) {
+        return alg.GetNumOfExpandedWithFGreaterC(solLen);
+    }
+
+    static void AppendCounters(HashDistributedBAE<state, action, environment> &alg, std::string &out) {
+        alg.AppendCounters(out);
+    }
+};
+
+/**
+ * Summary of the times of the repetitions of a single run
+ */
+struct TimeStats {
+    double min = 0, median = 0, mean = 0, stdev = 0;
+
+    static TimeStats Of(std::vector<double> times) {
+        TimeStats stats;
+        if (times.empty())
+            return stats;
+        std::sort(times.begin(), times.end());
+        size_t n = times.size();
+        stats.min = times[0];
+        stats.median = n % 2 == 1 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+        for (double t: times)
+            stats.mean += t;
+        stats.mean /= n;
+        if (n > 1) {
+            double sumSquares = 0;
+            for (double t: times)
+                sumSquares += (t - stats.mean) * (t - stats.mean);
+            stats.stdev = std::sqrt(sumSquares / (n - 1)); // Sample standard deviation
+        }
+        return stats;
+    }
+};
+
+/**
+ * Maps algorithm names (as given to -a) to factories of search objects, all sharing a single timed-run and report
+ * routine. Registering an algorithm is a single call to Add with its type and constructor arguments, see
+ * AddDirectionAlgorithms below.
+ */
+template<class state, class action, class environment>
+class AlgorithmRegistry {
+public:
+    /**
+     * @param solutionDecimals_ Number of decimals used when printing the solution length
+     * @param options_ How every run is executed (reuse, limits and repetitions)
+     */
+    explicit AlgorithmRegistry(int solutionDecimals_ = 0, const RunOptions &options_ = RunOptions())
+            : solutionDecimals(solutionDecimals_), options(options_) {}
+
+    /**
+     * Registers an algorithm
+     * @tparam search The search class, must have GetPath, SetLimits, GetSearchStatus, GetBestLowerBound,
+     * GetBestUpperBound and the GetNodesExpanded, GetUniqueNodesExpanded, GetNodesTouched and GetNecessaryExpansions
+     * counters, and whatever its SearchReport reads (by default GetDirectionPolicy and GetNumOfExpandedWithFGreaterC)
+     * @param name The name of the algorithm, both on the command line and in the output
+     * @param args The arguments passed to the constructor of search
+     */
+    template<class search, class... Args>
+    void Add(const std::string &name, Args... args) {
+        RunOptions opts = options;
+        // In reuse mode the object is created on first use and then reset by GetPath at the start of every run,
+        // so its open/closed lists keep the capacity they grew to in earlier runs
+        auto slot = std::make_shared<std::unique_ptr<search>>();
+        entries.push_back(Entry{name, [name, opts, slot, args...](environment &env, const state &start,
+                                                                   const state &goal, std::vector<state> &path,
+                                                                   Timer &timer) {
+            // Every repetition runs exactly like a single run would, including building a new object
+            std::vector<double> times;
+            for (int r = 0; r < opts.warmup + opts.repeat; ++r) {
+                if (!opts.reuse || !*slot) {
+                    slot->reset();
+                    slot->reset(new search(args...));
+                    (*slot)->SetLimits(opts.limits);
+                }
+                double time = TimedGetPath(**slot, env, start, goal, path, timer);
+                if (r >= opts.warmup)
+                    times.push_back(time);
+            }
+            // When racing, the first search to solve the instance stops the others
+            if (opts.limits.cancel != nullptr && (*slot)->GetSearchStatus() == SearchStatus::Solved)
+                opts.limits.cancel->Cancel(name);
+            return Collect(**slot, env, path, times);
+        }});
+    }
+
+    const RunOptions &GetOptions() const { return options; }
+
+    bool Has(const std::string &name) const { return Find(name) != nullptr; }
+
+    /**
+     * Exits with an error if any of the given algorithms is not registered
+     */
+    void VerifyAlgorithms(const std::vector<std::string> &names) const {
+        for (const auto &name: names) {
+            if (!Has(name)) {
+                std::cerr << "Error: Unknown algorithm: " << name << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    /**
+     * Runs a registered algorithm on a single instance, and records it in the results sink if there is one
+     * @param id The id of the instance, as reported in the results
+     * @return The [R] line of the run, or an empty string if there is no such algorithm
+     */
+    std::string Run(const std::string &name, int id, environment &env, const state &start, const state &goal,
+                    std::vector<state> &path, Timer &timer) const {
+        const Entry *entry = Find(name);
+        if (entry == nullptr)
+            return "";
+        RunRecord record = entry->run(env, start, goal, path, timer);
+        record.id = id;
+        record.alg = name;
+        if (options.sink != nullptr)
+            options.sink->Write(record);
+        return FormatLine(record);
+    }
+
+private:
+    using RunFn = std::function<RunRecord(environment &, const state &, const state &, std::vector<state> &,
+                                          Timer &)>;
+
+    struct Entry {
+        std::string name;
+        RunFn run;
+    };
+
+    const Entry *Find(const std::string &name) const {
+        for (const auto &entry: entries) {
+            if (entry.name == name)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+    template<class search>
+    static double TimedGetPath(search &alg, environment &env, const state &start, const state &goal,
+                               std::vector<state> &path, Timer &timer) {
+        timer.StartTimer();
+        alg.GetPath(&env, start, goal, &env, &env, path);
+        return timer.EndTimer();
+    }
+
+    /**
+     * Gathers the results of a finished run
+     * @param times The time of every timed repetition of the run
+     */
+    template<class search>
+    static RunRecord Collect(search &alg, environment &env, std::vector<state> &path,
+                             const std::vector<double> &times) {
+        RunRecord record;
+        // A search stopped by a limit has no solution to report, only the bounds it reached
+        record.status = alg.GetSearchStatus();
+        if (record.status == SearchStatus::Solved) {
+            record.solution = SearchReport<search>::SolutionLength(alg, env, path);
+            record.fAbove = SearchReport<search>::FAbove(alg, record.solution);
+        }
+        record.lowerBound = alg.GetBestLowerBound();
+        record.upperBound = alg.GetBestUpperBound();
+        record.expanded = alg.GetNodesExpanded();
+        record.unique = alg.GetUniqueNodesExpanded();
+        record.touched = alg.GetNodesTouched();
+        record.necessary = alg.GetNecessaryExpansions();
+        SearchReport<search>::AppendCounters(alg, record.counters);
+
+        TimeStats stats = TimeStats::Of(times);
+        record.runs = static_cast<int>(times.size());
+        record.time = stats.median;
+        record.timeMin = stats.min;
+        record.timeMean = stats.mean;
+        record.timeStdev = stats.stdev;
+        return record;
+    }
+
+    /**
+     * Builds the [R] line of a run. In benchmark mode the timing statistics are added, and the time is the median.
+     */
+    std::string FormatLine(const RunRecord &r) const {
+        int decimals = solutionDecimals;
+        std::string out;
+        AppendFormat(out, "[R] alg: %s; status: %s; solution: %1.*f; expanded: %llu; fabove: %lld; ", r.alg.c_str(),
+                     SearchStatusName(r.status), decimals, r.solution, (unsigned long long) r.expanded,
+                     (long long) r.fAbove);
+        AppendBound(out, "lb", r.lowerBound, decimals);
+        AppendBound(out, "ub", r.upperBound, decimals);
+        out += r.counters;
+        if (!options.IsBenchmark()) {
+            AppendFormat(out, "time: %1.6fs\n", r.time);
+            return out;
+        }
+        double expansionsPerSecond = r.time > 0 ? r.expanded / r.time : 0;
+        AppendFormat(out, "time: %1.6fs; runs: %d; tmin: %1.6fs; tmedian: %1.6fs; tmean: %1.6fs; tstdev: %1.6fs; "
+                          "eps: %1.0f\n", r.time, r.runs, r.timeMin, r.time, r.timeMean, r.timeStdev,
+                     expansionsPerSecond);
+        return out;
+    }
+
+    static void AppendBound(std::string &out, const char *key, double bound, int decimals) {
+        if (bound == DBL_MAX)
+            AppendFormat(out, "%s: inf; ", key);
+        else
+            AppendFormat(out, "%s: %1.*f; ", key, decimals, bound);
+    }
+
+    int solutionDecimals;
+    RunOptions options;
+    std::vector<Entry> entries;
+};
+
+/**
+ * BAE* with its default open list and statistics, and the given direction policy and cost type (see CostType.h)
+ */
+template<class state, class action, class environment, class direction, class cost = double>
+using BAEWithDirection = BAE<state, action, environment,
+        BDSharedOpenClosed<state, BAECompare<state, cost>, BAEOpenClosedData<state, cost>>, BoundHistogram, direction>;
+
+/**
+ * Registers every direction-choosing variant used in the paper
+ * @param epsilon Cost of the least-cost edge
+ * @param gcd Greatest common denominator between all edges
+ */
+template<class state, class action, class environment>
+void AddDirectionAlgorithms(AlgorithmRegistry<state, action, environment> &registry, double epsilon, double gcd) {
+    using BAEAlg = BAEWithDirection<state, action, environment, AlternatingDirection>;
+    using BAEPohlAlg = BAEWithDirection<state, action, environment, CardinalityDirection>;
+    using BFDAlg = BAEWithDirection<state, action, environment, BFDDirection<BFDTieBreak::Alternate>>;
+    using BFDForwardAlg = BAEWithDirection<state, action, environment, BFDDirection<BFDTieBreak::Forward>>;
+    using BFDBackwardAlg = BAEWithDirection<state, action, environment, BFDDirection<BFDTieBreak::Backward>>;
+    using BestBoundAlg = BAEWithDirection<state, action, environment, BestBoundDirection>;
+    using CostAlg = BAEWithDirection<state, action, environment, ExpansionCostDirection>;
+    using BAEIntAlg = BAEWithDirection<state, action, environment, AlternatingDirection, int32_t>;
+    using BAEPohlIntAlg = BAEWithDirection<state, action, environment, CardinalityDirection, int32_t>;
+    typedef BDBucketOpenClosed<state, BAEOpenClosedData<state>> bucketQueue;
+    using BAEBucketAlg = BAE<state, action, environment, bucketQueue, BoundHistogram, AlternatingDirection>;
+    using BAEPohlBucketAlg = BAE<state, action, environment, bucketQueue, BoundHistogram, CardinalityDirection>;
+    using TLBAEAlg = TwoLevelBAE<state, action, environment, BoundHistogram, AlternatingDirection>;
+    using TLBAEPohlAlg = TwoLevelBAE<state, action, environment, BoundHistogram, CardinalityDirection>;
+    using TLBAECompactAlg = TwoLevelBAE<state, action, environment, BoundHistogram, AlternatingDirection,
+            FCostHistogram, BDCompactStorage<state>>;
+    using TLBAEPohlCompactAlg = TwoLevelBAE<state, action, environment, BoundHistogram, CardinalityDirection,
+            FCostHistogram, BDCompactStorage<state>>;
+    using DBBSAlg = DBBS<state, action, environment, MinCriterion::MinB, AlternatingDirection>;
+    using DBBSPohlAlg = DBBS<state, action, environment, MinCriterion::MinB, CardinalityDirection>;
+    using FlatBucketList = BestBucketBasedList<state, environment, BucketNodeData<state>, MinCriterion::MinB,
+            BucketGridLayers<state>>;
+    using DBBSFlatAlg = DBBS<state, action, environment, MinCriterion::MinB, AlternatingDirection, FlatBucketList>;
+    using DBBSPohlFlatAlg = DBBS<state, action, environment, MinCriterion::MinB, CardinalityDirection, FlatBucketList>;
+
+    registry.template Add<BAEAlg>("BAE-a", epsilon, gcd);
+    registry.template Add<BAEPohlAlg>("BAE-p", epsilon, gcd);
+    registry.template Add<BFDAlg>("BAE-bfd-a", epsilon, gcd);
+    registry.template Add<BFDForwardAlg>("BAE-bfd-f", epsilon, gcd);
+    registry.template Add<BFDBackwardAlg>("BAE-bfd-b", epsilon, gcd);
+    registry.template Add<BestBoundAlg>("BAE-bb", epsilon, gcd);
+    registry.template Add<CostAlg>("BAE-cost", epsilon, gcd);
+    // Integer costs in units of the gcd, exact when every edge cost is a multiple of it
+    registry.template Add<BAEIntAlg>("BAE-a-int", epsilon, gcd);
+    registry.template Add<BAEPohlIntAlg>("BAE-p-int", epsilon, gcd);
+    // Open nodes in buckets of b and g in units of the gcd instead of a heap
+    registry.template Add<BAEBucketAlg>("BAE-a-bucket", epsilon, gcd);
+    registry.template Add<BAEPohlBucketAlg>("BAE-p-bucket", epsilon, gcd);
+    registry.template Add<TLBAEAlg>("TLBAE-a", gcd);
+    registry.template Add<TLBAEPohlAlg>("TLBAE-p", gcd);
+    // The nodes in separate arrays, with packed states
+    registry.template Add<TLBAECompactAlg>("TLBAE-a-compact", gcd);
+    registry.template Add<TLBAEPohlCompactAlg>("TLBAE-p-compact", gcd);
+    registry.template Add<DBBSAlg>("DBBS-a", true, epsilon, gcd);
+    registry.template Add<DBBSPohlAlg>("DBBS-p", true, epsilon, gcd);
+    // The buckets in flat arrays indexed by the costs in units of the gcd
+    registry.template Add<DBBSFlatAlg>("DBBS-a-flat", true, epsilon, gcd);
+    registry.template Add<DBBSPohlFlatAlg>("DBBS-p-flat", true, epsilon, gcd);
+    // Both directions at once on two threads, so it has no direction policy
+    registry.template Add<ParallelBAE<state, action, environment>>("BAE-par", epsilon, gcd);
+    // Each direction spread over --search-threads threads by the hash of the states
+    registry.template Add<HashDistributedBAE<state, action, environment>>("BAE-hd", epsilon, gcd,
+                                                                        registry.GetOptions().searchThreads);
+}
+
+/**
+ * Registers BAE* with its states indexed directly by their hash (see BDDirectIndex.h), for the domains whose state hash
+ * is a perfect hash with a small bound, i.e., grids
+ */
+template<class state, class action, class environment>
+void AddDirectIndexAlgorithms(AlgorithmRegistry<state, action, environment> &registry, double epsilon, double gcd) {
+    typedef BDSharedOpenClosed<state, BAECompare<state>, BAEOpenClosedData<state>, BDDirectIndex> directQueue;
+    using BAEAlg = BAE<state, action, environment, directQueue, BoundHistogram, AlternatingDirection>;
+    using BAEPohlAlg = BAE<state, action, environment, directQueue, BoundHistogram, CardinalityDirection>;
+
+    registry.template Add<BAEAlg>("BAE-a-direct", epsilon, gcd);
+    registry.template Add<BAEPohlAlg>("BAE-p-direct", epsilon, gcd);
+}
+
+#endif //SRC_PAPER_ALGORITHMREGISTRY_H
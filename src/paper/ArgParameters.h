@@ -6,6 +6,8 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include "RunOptions.h"
+#include "ResultsSink.h"
 
 class ArgParameters {
 public:
@@ -42,12 +44,57 @@ public:
                     ++i;
                 }
                 --i; // Adjust for the loop increment
+            } else if (arg == "-t" || arg == "--threads") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->threads = static_cast<int>(ArgParameters::parsePositiveInt(arg, argv[i]));
+            } else if (arg == "--race") {
+                this->race = true;
+            } else if (arg == "--search-threads") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->run.searchThreads = static_cast<int>(ArgParameters::parsePositiveInt(arg, argv[i]));
+            } else if (arg == "--reuse") {
+                this->run.reuse = true;
+            } else if (arg == "--max-expansions") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->run.limits.maxExpansions = ArgParameters::parsePositiveInt(arg, argv[i]);
+            } else if (arg == "--time-limit") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->run.limits.maxSeconds = ArgParameters::parsePositiveDouble(arg, argv[i]);
+            } else if (arg == "--memory-limit") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->run.limits.maxMemoryMB = ArgParameters::parsePositiveInt(arg, argv[i]);
+            } else if (arg == "--repeat") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->run.repeat = static_cast<int>(ArgParameters::parsePositiveInt(arg, argv[i]));
+            } else if (arg == "--warmup") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->run.warmup = static_cast<int>(ArgParameters::parseNonNegativeInt(arg, argv[i]));
+            } else if (arg == "--results") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->resultsFile = argv[i];
+                if (!this->explicitResultsFormat)
+                    this->resultsFormat = ResultsSink::FormatOfPath(this->resultsFile);
+            } else if (arg == "--results-format") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                if (!ResultsSink::ParseFormat(argv[i], this->resultsFormat)) {
+                    std::cerr << "Error: Unknown results format: " << argv[i] << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                this->explicitResultsFormat = true;
+            } else if (arg == "--pin-core") {
+                ArgParameters::verifyValidFlagValue(argc, argv, ++i);
+                this->pinCore = static_cast<int>(ArgParameters::parseNonNegativeInt(arg, argv[i]));
             } else {
                 std::cerr << "Error: Unknown argument: " << arg << std::endl;
                 exit(EXIT_FAILURE);
             }
         }
 
+        if (this->race && this->run.IsBenchmark()) {
+            std::cerr << "Error: --race cannot be combined with --repeat or --warmup" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
         // Lowercase domain and heuristic, so it's easier to work with them later
         std::transform(this->domain.begin(), this->domain.end(), this->domain.begin(),
                        [](unsigned char c) { return std::tolower(c); });
@@ -107,6 +154,23 @@ public:
         for (const auto &instance: params.instances) { os << instance << " "; }
         os << "\n";
 
+        os << "Threads: " << params.threads << "\n";
+
+        os << "Race: " << (params.race ? "yes" : "no") << "\n";
+
+        os << "Search threads: " << params.run.searchThreads << " per direction (BAE-hd)\n";
+
+        os << "Reuse: " << (params.run.reuse ? "yes" : "no") << "\n";
+
+        os << "Limits: expansions " << params.run.limits.maxExpansions << ", seconds " << params.run.limits.maxSeconds
+           << ", memory MB " << params.run.limits.maxMemoryMB << " (0 is unlimited)\n";
+
+        os << "Repetitions: " << params.run.repeat << " (warm-up " << params.run.warmup << ")\n";
+
+        os << "Results file: " << (params.resultsFile.empty() ? "none" : params.resultsFile) << "\n";
+
+        os << "Pinned core: " << (params.pinCore < 0 ? "none" : std::to_string(params.pinCore)) << "\n";
+
         return os;
     }
 
@@ -119,11 +183,26 @@ public:
         std::cout << "  -s, --scenario <FILE>         Specify the scenario file.\n";
         std::cout << "  -i, --instances <LIST>        Specify instances (e.g., 1 2 5-10).\n";
         std::cout << "  -a, --algorithms <LIST>       Specify algorithms (space-separated).\n";
+        std::cout << "  -t, --threads <N>             Run instances and algorithms on N worker threads (default 1).\n";
+        std::cout << "  --race                        Race the algorithms on every instance, one thread each.\n";
+        std::cout << "  --search-threads <N>          Run BAE-hd with N threads per direction (default 2).\n";
+        std::cout << "  --reuse                       Keep one search object per algorithm for the whole sweep.\n";
+        std::cout << "  --max-expansions <N>          Stop a single run after N expansions.\n";
+        std::cout << "  --time-limit <SECONDS>        Stop a single run after the given wall time.\n";
+        std::cout << "  --memory-limit <MB>           Stop a run once the process uses more resident memory.\n";
+        std::cout << "  --repeat <K>                  Time every run K times and report statistics (default 1).\n";
+        std::cout << "  --warmup <W>                  Do W untimed runs before the timed ones (default 0).\n";
+        std::cout << "  --results <FILE>              Also write a record of every run to FILE.\n";
+        std::cout << "  --results-format <FORMAT>     csv, jsonl or bin (default: from the extension of FILE, or csv).\n";
+        std::cout << "  --pin-core <CORE>             Pin the process to CORE onward, one core per thread: -t times\n";
+        std::cout << "                                the threads of one search (1, 2 for BAE-par,\n";
+        std::cout << "                                2 x --search-threads for BAE-hd).\n";
         std::cout << "  --help                        Show this help message and exit.\n\n";
         std::cout << "Examples:\n";
         std::cout << "  program -d grid -h od -i 0-1000 -a BAE-a TLBAE ";
         std::cout << "-m maps/orz302d.map -s scenarios/orz302d.map.scen\n";
         std::cout << "  program -d pancake -h 0 -i 0-100 -a BAE-a TLBAE\n";
+        std::cout << "  program -d stp -h md -i 0-100 -a BAE-a BAE-p -t 64\n";
 
         std::exit(EXIT_SUCCESS);
     }
@@ -134,8 +213,44 @@ public:
     std::vector<int> instances;
     std::string map;
     std::string scenario;
+    int threads = 1;
+    bool race = false;
+    RunOptions run;
+    int pinCore = -1;
+    std::string resultsFile;
+    ResultsFormat resultsFormat = ResultsFormat::CSV;
 
 private:
+    bool explicitResultsFormat = false;
+
+    static long long parsePositiveInt(const std::string &flag, const std::string &value) {
+        try {
+            long long number = std::stoll(value);
+            if (number > 0)
+                return number;
+        } catch (const std::exception &e) {
+        }
+        std::cerr << "Error: Invalid value for " << flag << ": " << value << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    static long long parseNonNegativeInt(const std::string &flag, const std::string &value) {
+        if (value == "0")
+            return 0;
+        return parsePositiveInt(flag, value);
+    }
+
+    static double parsePositiveDouble(const std::string &flag, const std::string &value) {
+        try {
+            double number = std::stod(value);
+            if (number > 0)
+                return number;
+        } catch (const std::exception &e) {
+        }
+        std::cerr << "Error: Invalid value for " << flag << ": " << value << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
     static void verifyValidFlagValue(int argc, char *argv[], int index) {
         if (index >= argc || argv[index][0] == '-') {
             std::cerr << "Missing values for: " << argv[index - 1] << std::endl;
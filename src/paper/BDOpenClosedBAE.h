@@ -6,21 +6,24 @@
 #define BDOpenClosedBAEBAE_H
 
 #include <cassert>
+#include <cfloat>
 #include <vector>
-#include <unordered_map>
 #include <stdint.h>
-#include <unordered_map>
 #include "AStarOpenClosed.h"
+#include "BDSharedOpenClosed.h"
+#include "CompactState.h"
 
 enum stateLocation {
-    kOpenReady = 0,//priority queue 0, low g -> low f
-    kOpenWaiting = 1,//priority queue 1, low f -> low g
+    kOpenReady = 0,//priority queue, low b -> high g
+    kOpenWaiting = 1,//layers of equal f
     kClosed,
     kUnseen
 };
 
 
 const uint64_t kTBDNoNode = 0xFFFFFFFFFFFFFFFFull;
+// Marks the first node of a waiting layer, whose prevWaiting holds the layer instead of a node
+const uint64_t kTBDLayerHead = 0x8000000000000000ull;
 
 template<typename state>
 class BDOpenClosedBAEData {
@@ -38,22 +41,167 @@ public:
     double h;
     double rh;
     uint64_t parentID;
-    uint64_t openLocation;
+    uint64_t openLocation; // Index in the ready queue, or the next node in the layer of a waiting node
+    uint64_t prevWaiting; // Previous node in the layer of a waiting node, kTBDLayerHead | layer for the first one
     bool reopened;
     stateLocation where;
 };
 
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure = BDOpenClosedBAEData<state> >
+/**
+ * Keeps every node in a single BDOpenClosedBAEData record, which is also what the comparator of the ready queue reads.
+ */
+template<typename state>
+class BDRecordStorage {
+public:
+    typedef BDOpenClosedBAEData<state> keys;
+
+    void clear() { elements.clear(); }
+
+    size_t size() const { return elements.size(); }
+
+    uint64_t Add(const state &val, double g, double h, double rh, uint64_t parent) {
+        elements.push_back(BDOpenClosedBAEData<state>(val, g, h, rh, parent, 0, kClosed));
+        return elements.size() - 1;
+    }
+
+    keys &Keys(uint64_t id) { return elements[id]; }
+
+    const keys &Keys(uint64_t id) const { return elements[id]; }
+
+    void GetState(uint64_t id, state &s) const { s = elements[id].data; }
+
+    uint64_t &Parent(uint64_t id) { return elements[id].parentID; }
+
+    uint64_t &OpenLocation(uint64_t id) { return elements[id].openLocation; }
+
+    uint64_t &PrevWaiting(uint64_t id) { return elements[id].prevWaiting; }
+
+    stateLocation &Where(uint64_t id) { return elements[id].where; }
+
+    stateLocation Where(uint64_t id) const { return elements[id].where; }
+
+    bool &Reopened(uint64_t id) { return elements[id].reopened; }
+
+private:
+    std::vector<BDOpenClosedBAEData<state>> elements;
+};
+
+/**
+ * Keeps every field of the nodes in its own array. The costs read by the comparator of the ready queue are dense, so
+ * sifting the heap touches 24 bytes per node instead of a whole record, and the states are packed by CompactState and
+ * unpacked when they are expanded. A node of the 15-puzzle or the 16-pancake takes 64 bytes, instead of 128 and 120 as
+ * a BDOpenClosedBAEData record.
+ */
+template<typename state>
+class BDCompactStorage {
+public:
+    struct keys {
+        double g;
+        double h;
+        double rh;
+    };
+
+    void clear() {
+        costs.clear();
+        states.clear();
+        parents.clear();
+        openLocations.clear();
+        prevWaiting.clear();
+        flags.clear();
+    }
+
+    size_t size() const { return costs.size(); }
+
+    uint64_t Add(const state &val, double g, double h, double rh, uint64_t parent) {
+        costs.push_back(keys{g, h, rh});
+        states.emplace_back();
+        CompactState<state>::Pack(val, states.back());
+        parents.push_back(parent);
+        openLocations.push_back(0);
+        prevWaiting.push_back(kTBDNoNode);
+        flags.push_back(Flags{kClosed, false});
+        return costs.size() - 1;
+    }
+
+    keys &Keys(uint64_t id) { return costs[id]; }
+
+    const keys &Keys(uint64_t id) const { return costs[id]; }
+
+    void GetState(uint64_t id, state &s) const { CompactState<state>::Unpack(states[id], s); }
+
+    uint64_t &Parent(uint64_t id) { return parents[id]; }
+
+    uint64_t &OpenLocation(uint64_t id) { return openLocations[id]; }
+
+    uint64_t &PrevWaiting(uint64_t id) { return prevWaiting[id]; }
+
+    stateLocation &Where(uint64_t id) { return flags[id].where; }
+
+    stateLocation Where(uint64_t id) const { return flags[id].where; }
+
+    bool &Reopened(uint64_t id) { return flags[id].reopened; }
+
+private:
+    struct Flags {
+        stateLocation where;
+        bool reopened;
+    };
+
+    std::vector<keys> costs;
+    std::vector<typename CompactState<state>::packed> states;
+    std::vector<uint64_t> parents;
+    std::vector<uint64_t> openLocations; // See BDOpenClosedBAEData
+    std::vector<uint64_t> prevWaiting;
+    std::vector<Flags> flags;
+};
+
+/**
+ * The open/closed list of one direction of TwoLevelBAE. States are indexed in a BDSharedIndex shared with the list of
+ * the opposite direction, so the records of a state in both directions are found with a single probe.
+ *
+ * Open nodes are either ready, kept in a heap ordered by CmpKey0, or waiting, kept in layers of equal f-cost. A waiting
+ * node only leaves its layer when the whole layer becomes ready, so waiting nodes need no order within a layer, and
+ * moving a layer costs a single heap insertion per node (or a single rebuild of the heap, if the layer is larger than
+ * it). A layer is a list linked through the node records, which only adds the back link to them, as the forward link
+ * takes the place of the heap index of a ready node. The layers are indexed by round(f / gcd), so every f-cost must be
+ * a multiple of the gcd, as in all the domains of the paper.
+ *
+ * The fields of the nodes are kept by nodeStorage, either in one record per node (BDRecordStorage) or in an array per
+ * field (BDCompactStorage).
+ */
+template<typename state, typename CmpKey0, class nodeStorage = BDRecordStorage<state> >
 class BDOpenClosedBAE {
 public:
     BDOpenClosedBAE();
 
     ~BDOpenClosedBAE();
 
+    /**
+     * Attaches the list to the index shared with the opposite direction
+     * @param side_ 0 for the forward list, 1 for the backward list
+     */
+    void SetIndex(BDSharedIndex *index, int side_) {
+        sharedIndex = index;
+        side = side_;
+    }
+
+    /**
+     * @param gcd_ Greatest common denominator between all edges, which is the width of a waiting layer
+     */
+    void SetGranularity(double gcd_) {
+        gcd = gcd_;
+        layersPerCost = 1 / gcd_;
+    }
+
     void Reset(int);
 
     uint64_t AddOpenNode(const state &val, uint64_t hash, double g, double h, double rh, uint64_t parent = kTBDNoNode,
-                         stateLocation whichQueue = kOpenWaiting);
+                         stateLocation whichQueue = kOpenWaiting) {
+        return AddOpenNode(val, sharedIndex->Insert(hash), g, h, rh, parent, whichQueue);
+    }
+
+    uint64_t AddOpenNode(const state &val, BDSharedSlot &slot, double g, double h, double rh,
+                         uint64_t parent = kTBDNoNode, stateLocation whichQueue = kOpenWaiting);
 
     uint64_t AddClosedNode(state &val, uint64_t hash, double g, double h, double rh, uint64_t parent = kTBDNoNode);
 
@@ -62,368 +210,390 @@ public:
     void Remove(uint64_t objKey);
 
     //void IncreaseKey(uint64_t objKey);
-    stateLocation Lookup(uint64_t hashKey, uint64_t &objKey) const;
+    stateLocation Lookup(uint64_t hashKey, uint64_t &objKey) const { return Lookup(sharedIndex->Find(hashKey), objKey); }
+
+    stateLocation Lookup(const BDSharedSlot *slot, uint64_t &objKey) const;
+
+    double &G(uint64_t objKey) { return nodes.Keys(objKey).g; }
 
-    inline dataStructure &Lookup(uint64_t objKey) { return elements[objKey]; }
+    double H(uint64_t objKey) const { return nodes.Keys(objKey).h; }
 
-    inline const dataStructure &Lookat(uint64_t objKey) const { return elements[objKey]; }
+    double RH(uint64_t objKey) const { return nodes.Keys(objKey).rh; }
 
-    uint64_t Peek(stateLocation whichQueue) const;
+    uint64_t &Parent(uint64_t objKey) { return nodes.Parent(objKey); }
 
-    inline const dataStructure &PeekAt(stateLocation whichQueue) const;
+    bool Reopened(uint64_t objKey) { return nodes.Reopened(objKey); }
+
+    stateLocation Where(uint64_t objKey) const { return nodes.Where(objKey); }
+
+    /**
+     * Copies the state of a node, unpacking it if the storage keeps it packed
+     */
+    void GetState(uint64_t objKey, state &s) const { nodes.GetState(objKey, s); }
+
+    /**
+     * Peek at the next ready item to be expanded.
+     */
+    uint64_t Peek() const {
+        assert(OpenReadySize() != 0);
+        return readyQueue[0];
+    }
+
+    /**
+     * @return The costs (g, h and rh) of the next ready item
+     */
+    inline const typename nodeStorage::keys &PeekAt() const { return nodes.Keys(Peek()); }
+
+    /**
+     * @return The f-cost of the lowest waiting layer, DBL_MAX if no node is waiting
+     */
+    double WaitingMinF() const { return waitingSize == 0 ? DBL_MAX : (baseLayer + minLayer) * gcd; }
 
-    //if exist min pair, return true, else(one queue is empty) return false;
-    //if it returns true, left and right should be set to the pair that is supposed to be returned.
-    //bool ExtractMinPair(uint64_t& left, uint64_t& right) ;
     uint64_t Close();
 
-    uint64_t PutToReady();
+    /**
+     * Moves the lowest waiting layer to the ready queue
+     * @return The number of nodes moved
+     */
+    size_t PutLayerToReady();
 
-    void Reopen(uint64_t objKey, stateLocation where=kOpenWaiting);
+    /**
+     * Moves a single waiting node to the ready queue
+     */
+    void PutToReady(uint64_t objKey);
 
-    uint64_t GetOpenItem(unsigned int which, stateLocation where) { return priorityQueues[where][which]; }
+    void Reopen(uint64_t objKey, stateLocation where=kOpenWaiting);
 
-    size_t OpenReadySize() const { return priorityQueues[kOpenReady].size(); }
+    size_t OpenReadySize() const { return readyQueue.size(); }
 
-    size_t OpenWaitingSize() const { return priorityQueues[kOpenWaiting].size(); }
+    size_t OpenWaitingSize() const { return waitingSize; }
 
-    size_t OpenSize() const { return priorityQueues[kOpenReady].size() + priorityQueues[kOpenWaiting].size(); }
+    size_t OpenSize() const { return OpenReadySize() + OpenWaitingSize(); }
 
     size_t ClosedSize() const { return size() - OpenReadySize() - OpenWaitingSize(); }
 
-    size_t size() const { return elements.size(); }
+    size_t size() const { return nodes.size(); }
 
     bool ValidateOpenReady(int index = 0) {
-        stateLocation whichQ = kOpenReady;
         CmpKey0 compare;
-        if (index >= priorityQueues[whichQ].size())
+        if (index >= readyQueue.size())
             return true;
         int child1 = index * 2 + 1;
         int child2 = index * 2 + 2;
-        if (priorityQueues[whichQ].size() > child1 &&
-            compare(elements[priorityQueues[whichQ][index]], elements[priorityQueues[whichQ][child1]]))
+        if (readyQueue.size() > child1 && compare(nodes.Keys(readyQueue[index]), nodes.Keys(readyQueue[child1])))
             return false;
-        if (priorityQueues[whichQ].size() > child2 &&
-            compare(elements[priorityQueues[whichQ][index]], elements[priorityQueues[whichQ][child2]]))
+        if (readyQueue.size() > child2 && compare(nodes.Keys(readyQueue[index]), nodes.Keys(readyQueue[child2])))
             return false;
         return ValidateOpenReady(child1) && ValidateOpenReady(child2);
     }
 
-    bool ValidateOpenWaiting(int index = 0) {
-        stateLocation whichQ = kOpenWaiting;
-        CmpKey1 compare;
-        if (index >= priorityQueues[whichQ].size())
-            return true;
-        int child1 = index * 2 + 1;
-        int child2 = index * 2 + 2;
-        if (priorityQueues[whichQ].size() > child1 &&
-            compare(elements[priorityQueues[whichQ][index]], elements[priorityQueues[whichQ][child1]]))
-            return false;
-        if (priorityQueues[whichQ].size() > child2 &&
-            compare(elements[priorityQueues[whichQ][index]], elements[priorityQueues[whichQ][child2]]))
-            return false;
-        return ValidateOpenWaiting(child1) && ValidateOpenWaiting(child2);
-    }
-
 private:
-    bool HeapifyUp(unsigned int index, stateLocation whichQueue);
+    bool HeapifyUp(unsigned int index);
 
-    void HeapifyDown(unsigned int index, stateLocation whichQueue);
+    void HeapifyDown(unsigned int index);
 
-    //2 queues:
-    //priorityQueues[0] is openReady, priorityQueues[1] is openWaiting
-    std::vector<std::vector<uint64_t>> priorityQueues;
+    void PushReady(uint64_t objKey);
 
-    // storing the element id; looking up with hash
-    std::unordered_map<uint64_t, size_t> table;
-    //all the elements, open or closed
-    std::vector<dataStructure> elements;
+    void PushWaiting(uint64_t objKey);
+
+    void PopWaiting(uint64_t objKey);
+
+    std::vector<uint64_t> readyQueue; // Heap of the ready nodes
+    std::vector<uint64_t> waitingLayers; // First waiting node of every layer, by round(f / gcd) - baseLayer
+    int64_t baseLayer; // round(f / gcd) of waitingLayers[0]
+    size_t minLayer; // Lowest non-empty waiting layer, if any node is waiting
+    size_t waitingSize;
+    double gcd;
+    double layersPerCost; // 1 / gcd
+
+    // storing the element id; looking up with hash. The index is reset by its owner.
+    BDSharedIndex *sharedIndex;
+    int side; // Which of the ids of a slot belongs to this list
+    //all the nodes, open or closed
+    nodeStorage nodes;
 };
 
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-void BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::Reopen(uint64_t objKey, stateLocation where)
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::Reopen(uint64_t objKey, stateLocation where)
 {
-    assert(elements[objKey].where == kClosed);
-    elements[objKey].reopened = true;
-    elements[objKey].where = where;
-    elements[objKey].openLocation = priorityQueues[where].size();
-    priorityQueues[where].push_back(objKey);
-    HeapifyUp(priorityQueues[where].size() - 1, where);
+    assert(nodes.Where(objKey) == kClosed);
+    nodes.Reopened(objKey) = true;
+    if (where == kOpenReady)
+        PushReady(objKey);
+    else
+        PushWaiting(objKey);
 }
 
 
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::BDOpenClosedBAE() {
-    std::vector<uint64_t> queue;
-    queue.resize(0);
-    priorityQueues.push_back(queue);
-    priorityQueues.push_back(queue);
+template<typename state, typename CmpKey0, class nodeStorage>
+BDOpenClosedBAE<state, CmpKey0, nodeStorage>::BDOpenClosedBAE()
+        : baseLayer(0), minLayer(0), waitingSize(0), gcd(1.0), layersPerCost(1.0), sharedIndex(nullptr), side(0) {
 }
 
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::~BDOpenClosedBAE() {
+template<typename state, typename CmpKey0, class nodeStorage>
+BDOpenClosedBAE<state, CmpKey0, nodeStorage>::~BDOpenClosedBAE() {
 }
 
 /**
- * Remove all objects from queue.
+ * Remove all objects from queue. Like AStarOpenClosed, the element list, the heap and the layers keep their capacity
+ * for the next search. The shared index is reset by its owner.
  */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-void BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::Reset(int) {
-    table.clear();
-    elements.clear();
-    priorityQueues[0].resize(0);
-    priorityQueues[1].resize(0);
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::Reset(int) {
+    nodes.clear();
+    readyQueue.resize(0);
+    waitingLayers.clear();
+    minLayer = 0;
+    waitingSize = 0;
 }
 
 /**
  * Add object into open list.
  */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
+template<typename state, typename CmpKey0, class nodeStorage>
 uint64_t
-BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::AddOpenNode(const state &val, uint64_t hash, double g,
-                                                                     double h,
-                                                                     double rh, uint64_t parent,
-                                                                     stateLocation whichQueue) {
-    // should do lookup here...
-    if (table.find(hash) != table.end()) {
-        assert(false);
-    }
-    if (whichQueue == kOpenReady) {
-        elements.push_back(dataStructure(val, g, h, rh, parent, priorityQueues[0].size(), kOpenReady));
-
-    } else if (whichQueue == kOpenWaiting) {
-        elements.push_back(dataStructure(val, g, h, rh, parent, priorityQueues[1].size(), kOpenWaiting));
-    }
+BDOpenClosedBAE<state, CmpKey0, nodeStorage>::AddOpenNode(const state &val, BDSharedSlot &slot, double g, double h,
+                                                            double rh, uint64_t parent, stateLocation whichQueue) {
+    assert(slot.id[side] == kTBDNoNode);
+    uint64_t objKey = nodes.Add(val, g, h, rh, parent);
 
     if (parent == kTBDNoNode)
-        elements.back().parentID = elements.size() - 1;
-    table[hash] = elements.size() - 1; // hashing to element list location
+        nodes.Parent(objKey) = objKey;
+    slot.id[side] = objKey; // hashing to element list location
 
-    priorityQueues[whichQueue].push_back(elements.size() - 1);
-    HeapifyUp(priorityQueues[whichQueue].size() - 1, whichQueue);
+    if (whichQueue == kOpenReady)
+        PushReady(objKey);
+    else
+        PushWaiting(objKey);
 
-    return elements.size() - 1;
+    return objKey;
 }
 
 /**
  * Add object into closed list.
  */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
+template<typename state, typename CmpKey0, class nodeStorage>
 uint64_t
-BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::AddClosedNode(state &val, uint64_t hash, double g, double h,
-                                                                       double rh, uint64_t parent) {
-    // should do lookup here...
-    assert(table.find(hash) == table.end());
-    elements.push_back(dataStructure(val, g, h, rh, parent, 0, kClosed));
+BDOpenClosedBAE<state, CmpKey0, nodeStorage>::AddClosedNode(state &val, uint64_t hash, double g, double h,
+                                                              double rh, uint64_t parent) {
+    BDSharedSlot &slot = sharedIndex->Insert(hash);
+    assert(slot.id[side] == kTBDNoNode);
+    uint64_t objKey = nodes.Add(val, g, h, rh, parent);
     if (parent == kTBDNoNode)
-        elements.back().parentID = elements.size() - 1;
-    table[hash] = elements.size() - 1; // hashing to element list location
-    return elements.size() - 1;
+        nodes.Parent(objKey) = objKey;
+    slot.id[side] = objKey; // hashing to element list location
+    return objKey;
 }
 
 /**
- * Indicate that the key for a particular object has changed.
+ * Indicate that the key for a particular object has changed. A waiting node moves to the layer of its new f-cost.
  */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-void BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::KeyChanged(uint64_t val) {
-    if (elements[val].where == kOpenReady) {
-        if (!HeapifyUp(elements[val].openLocation, kOpenReady))
-            HeapifyDown(elements[val].openLocation, kOpenReady);
-    } else if (elements[val].where == kOpenWaiting) {
-        if (!HeapifyUp(elements[val].openLocation, kOpenWaiting))
-            HeapifyDown(elements[val].openLocation, kOpenWaiting);
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::KeyChanged(uint64_t val) {
+    if (nodes.Where(val) == kOpenReady) {
+        if (!HeapifyUp(nodes.OpenLocation(val)))
+            HeapifyDown(nodes.OpenLocation(val));
+    } else if (nodes.Where(val) == kOpenWaiting) {
+        PopWaiting(val);
+        PushWaiting(val);
     }
 }
 
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-void BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::Remove(uint64_t val) {
-
-    int index = elements[val].openLocation;
-    stateLocation whichQueue = elements[val].where;
-    elements[val].where = kClosed;
-    priorityQueues[whichQueue][index] = priorityQueues[whichQueue][priorityQueues[whichQueue].size() - 1];
-    elements[priorityQueues[whichQueue][index]].openLocation = index;
-    priorityQueues[whichQueue].pop_back();
-
-    if (!HeapifyUp(index, whichQueue))
-        HeapifyDown(index, whichQueue);
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::Remove(uint64_t val) {
+    if (nodes.Where(val) == kOpenWaiting) {
+        PopWaiting(val);
+        nodes.Where(val) = kClosed;
+        return;
+    }
 
+    uint64_t index = nodes.OpenLocation(val);
+    nodes.Where(val) = kClosed;
+    readyQueue[index] = readyQueue.back();
+    nodes.OpenLocation(readyQueue[index]) = index;
+    readyQueue.pop_back();
 
+    if (index < readyQueue.size() && !HeapifyUp(index))
+        HeapifyDown(index);
 }
 
 /**
- * Returns location of object as well as object key.
+ * Returns location of object as well as object key, for a slot already found in the shared index (or nullptr).
  */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
+template<typename state, typename CmpKey0, class nodeStorage>
 stateLocation
-BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::Lookup(uint64_t hashKey, uint64_t &objKey) const {
-    auto it = table.find(hashKey);
-    if (it == table.end())
+BDOpenClosedBAE<state, CmpKey0, nodeStorage>::Lookup(const BDSharedSlot *slot, uint64_t &objKey) const {
+    if (slot == nullptr || slot->id[side] == kTBDNoNode)
         return kUnseen;
 
-    objKey = it->second;
-    return elements[objKey].where;
-}
-
-
-/**
- * Peek at the next item to be expanded.
- */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-uint64_t BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::Peek(stateLocation whichQueue) const {
-    if (whichQueue == kOpenReady) {
-        assert(OpenReadySize() != 0);
-    } else if (whichQueue == kOpenWaiting) {
-        assert(OpenWaitingSize() != 0);
-    }
-    return priorityQueues[whichQueue][0];
-}
-
-/**
- * Peek at the next item to be expanded.
- */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-inline const dataStructure &
-BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::PeekAt(stateLocation whichQueue) const {
-    if (whichQueue == kOpenReady) {
-        assert(OpenReadySize() != 0);
-    } else if (whichQueue == kOpenWaiting) {
-        assert(OpenWaitingSize() != 0);
-    }
-    return elements[priorityQueues[whichQueue][0]];
+    objKey = slot->id[side];
+    return nodes.Where(objKey);
 }
 
-
 /**
- * Move the best item to the closed list and return key.
+ * Move the best ready item to the closed list and return key.
  */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-uint64_t BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::Close() {
+template<typename state, typename CmpKey0, class nodeStorage>
+uint64_t BDOpenClosedBAE<state, CmpKey0, nodeStorage>::Close() {
     assert(OpenReadySize() != 0);
 
-    uint64_t ans = priorityQueues[0][0];
-    elements[ans].where = kClosed;
-    priorityQueues[0][0] = priorityQueues[0][OpenReadySize() - 1];
-    elements[priorityQueues[0][0]].openLocation = 0;
-    priorityQueues[0].pop_back();
+    uint64_t ans = readyQueue[0];
+    nodes.Where(ans) = kClosed;
+    readyQueue[0] = readyQueue.back();
+    nodes.OpenLocation(readyQueue[0]) = 0;
+    readyQueue.pop_back();
 
-    HeapifyDown(0, kOpenReady);
+    HeapifyDown(0);
 
     return ans;
 }
 
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-uint64_t BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::PutToReady() {
+template<typename state, typename CmpKey0, class nodeStorage>
+size_t BDOpenClosedBAE<state, CmpKey0, nodeStorage>::PutLayerToReady() {
     assert(OpenWaitingSize() != 0);
 
-    //remove it from openWaiting
-    uint64_t ans = priorityQueues[kOpenWaiting][0];
-    uint64_t back = priorityQueues[kOpenWaiting].back();
-    priorityQueues[kOpenWaiting][0] = back;
-    priorityQueues[kOpenWaiting].pop_back();
-    elements[back].openLocation = 0;
+    // Splice the whole layer out, then append its nodes to the heap
+    uint64_t next = waitingLayers[minLayer];
+    waitingLayers[minLayer] = kTBDNoNode;
+    size_t heapSize = readyQueue.size();
+    while (next != kTBDNoNode) {
+        uint64_t objKey = next;
+        next = nodes.OpenLocation(objKey);
+        nodes.Where(objKey) = kOpenReady;
+        nodes.OpenLocation(objKey) = readyQueue.size();
+        readyQueue.push_back(objKey);
+    }
+    size_t moved = readyQueue.size() - heapSize;
+    waitingSize -= moved;
+    if (moved > heapSize) {
+        // Cheaper to rebuild the heap bottom-up than to sift every node up
+        for (size_t i = readyQueue.size() / 2; i > 0; i--)
+            HeapifyDown(i - 1);
+    } else {
+        for (size_t i = heapSize; i < readyQueue.size(); i++)
+            HeapifyUp(i);
+    }
 
-    HeapifyDown(0, kOpenWaiting);
+    // With no node waiting, the next push sets the lowest layer, so there is no need to scan the empty ones
+    while (waitingSize > 0 && waitingLayers[minLayer] == kTBDNoNode)
+        minLayer++;
+    return moved;
+}
 
-    //put it to openReady
-    priorityQueues[kOpenReady].push_back(ans);
-    elements[ans].where = kOpenReady;
-    elements[ans].openLocation = priorityQueues[kOpenReady].size() - 1;
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::PutToReady(uint64_t objKey) {
+    assert(nodes.Where(objKey) == kOpenWaiting);
+    PopWaiting(objKey);
+    PushReady(objKey);
+}
 
-    HeapifyUp(priorityQueues[kOpenReady].size() - 1, kOpenReady);
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::PushReady(uint64_t objKey) {
+    nodes.Where(objKey) = kOpenReady;
+    nodes.OpenLocation(objKey) = readyQueue.size();
+    readyQueue.push_back(objKey);
+    HeapifyUp(readyQueue.size() - 1);
+}
 
-    return ans;
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::PushWaiting(uint64_t objKey) {
+    const typename nodeStorage::keys &costs = nodes.Keys(objKey);
+    // Costs are non-negative, so adding a half and truncating rounds to the nearest layer
+    int64_t key = static_cast<int64_t>((costs.g + costs.h) * layersPerCost + 0.5);
+    if (waitingLayers.empty())
+        baseLayer = key;
+    if (key < baseLayer) {
+        // Rare, as f never decreases below the f of the root with a consistent heuristic
+        size_t shift = static_cast<size_t>(baseLayer - key);
+        for (uint64_t head: waitingLayers)
+            if (head != kTBDNoNode)
+                nodes.PrevWaiting(head) += shift;
+        waitingLayers.insert(waitingLayers.begin(), shift, kTBDNoNode);
+        minLayer += shift;
+        baseLayer = key;
+    }
+    size_t layer = static_cast<size_t>(key - baseLayer);
+    if (layer >= waitingLayers.size())
+        waitingLayers.resize(layer + 1, kTBDNoNode);
+    nodes.Where(objKey) = kOpenWaiting;
+    uint64_t next = waitingLayers[layer];
+    nodes.OpenLocation(objKey) = next;
+    nodes.PrevWaiting(objKey) = kTBDLayerHead | layer;
+    if (next != kTBDNoNode)
+        nodes.PrevWaiting(next) = objKey;
+    waitingLayers[layer] = objKey;
+    if (layer < minLayer || waitingSize == 0)
+        minLayer = layer;
+    waitingSize++;
+}
+
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::PopWaiting(uint64_t objKey) {
+    uint64_t prev = nodes.PrevWaiting(objKey);
+    uint64_t next = nodes.OpenLocation(objKey);
+    if (next != kTBDNoNode)
+        nodes.PrevWaiting(next) = prev;
+    waitingSize--;
+    if (!(prev & kTBDLayerHead)) {
+        nodes.OpenLocation(prev) = next;
+        return;
+    }
+    size_t layer = prev & ~kTBDLayerHead;
+    waitingLayers[layer] = next;
+    if (layer == minLayer) {
+        while (waitingSize > 0 && waitingLayers[minLayer] == kTBDNoNode)
+            minLayer++;
+    }
 }
 
 /**
  * Moves a node up the heap. Returns true if the node was moved, false otherwise.
  */
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-bool BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::HeapifyUp(unsigned int index, stateLocation whichQueue) {
+template<typename state, typename CmpKey0, class nodeStorage>
+bool BDOpenClosedBAE<state, CmpKey0, nodeStorage>::HeapifyUp(unsigned int index) {
     if (index == 0) return false;
     int parent = (index - 1) / 2;
 
-    if (whichQueue == kOpenReady) {
-        CmpKey0 compare;
-        if (compare(elements[priorityQueues[whichQueue][parent]], elements[priorityQueues[whichQueue][index]])) {
-            unsigned int tmp = priorityQueues[whichQueue][parent];
-            priorityQueues[whichQueue][parent] = priorityQueues[whichQueue][index];
-            priorityQueues[whichQueue][index] = tmp;
-            elements[priorityQueues[whichQueue][parent]].openLocation = parent;
-            elements[priorityQueues[whichQueue][index]].openLocation = index;
-            HeapifyUp(parent, whichQueue);
-            return true;
-        }
-    } else if (whichQueue == kOpenWaiting) {
-        CmpKey1 compare;
-        if (compare(elements[priorityQueues[whichQueue][parent]], elements[priorityQueues[whichQueue][index]])) {
-            unsigned int tmp = priorityQueues[whichQueue][parent];
-            priorityQueues[whichQueue][parent] = priorityQueues[whichQueue][index];
-            priorityQueues[whichQueue][index] = tmp;
-            elements[priorityQueues[whichQueue][parent]].openLocation = parent;
-            elements[priorityQueues[whichQueue][index]].openLocation = index;
-            HeapifyUp(parent, whichQueue);
-            return true;
-        }
+    CmpKey0 compare;
+    if (compare(nodes.Keys(readyQueue[parent]), nodes.Keys(readyQueue[index]))) {
+        unsigned int tmp = readyQueue[parent];
+        readyQueue[parent] = readyQueue[index];
+        readyQueue[index] = tmp;
+        nodes.OpenLocation(readyQueue[parent]) = parent;
+        nodes.OpenLocation(readyQueue[index]) = index;
+        HeapifyUp(parent);
+        return true;
     }
 
     return false;
 }
 
-template<typename state, typename CmpKey0, typename CmpKey1, class dataStructure>
-void
-BDOpenClosedBAE<state, CmpKey0, CmpKey1, dataStructure>::HeapifyDown(unsigned int index, stateLocation whichQueue) {
-
+template<typename state, typename CmpKey0, class nodeStorage>
+void BDOpenClosedBAE<state, CmpKey0, nodeStorage>::HeapifyDown(unsigned int index) {
     unsigned int child1 = index * 2 + 1;
     unsigned int child2 = index * 2 + 2;
 
-    if (whichQueue == kOpenReady) {
-        CmpKey0 compare;
-        int which;
-        unsigned int count = priorityQueues[whichQueue].size();
-        // find smallest child
-        if (child1 >= count)
-            return;
-        else if (child2 >= count)
-            which = child1;
-        else if (!(compare(elements[priorityQueues[whichQueue][child1]], elements[priorityQueues[whichQueue][child2]])))
-            which = child1;
-        else
-            which = child2;
-
-        if (!(compare(elements[priorityQueues[whichQueue][which]], elements[priorityQueues[whichQueue][index]]))) {
-            unsigned int tmp = priorityQueues[whichQueue][which];
-            priorityQueues[whichQueue][which] = priorityQueues[whichQueue][index];
-            priorityQueues[whichQueue][index] = tmp;
-            elements[priorityQueues[whichQueue][which]].openLocation = which;
-            elements[priorityQueues[whichQueue][index]].openLocation = index;
-            HeapifyDown(which, whichQueue);
-        }
-    } else if (whichQueue == kOpenWaiting) {
-        CmpKey1 compare;
-        int which;
-        unsigned int count = priorityQueues[whichQueue].size();
-        // find smallest child
-        if (child1 >= count) // no children; done
-            return;
-        else if (child2 >= count) // one child - compare there
-            which = child1;
-            // find larger child to move up
-        else if (!(compare(elements[priorityQueues[whichQueue][child1]], elements[priorityQueues[whichQueue][child2]])))
-            which = child1;
-        else
-            which = child2;
-
-        if (!(compare(elements[priorityQueues[whichQueue][which]], elements[priorityQueues[whichQueue][index]]))) {
-            unsigned int tmp = priorityQueues[whichQueue][which];
-            priorityQueues[whichQueue][which] = priorityQueues[whichQueue][index];
-            priorityQueues[whichQueue][index] = tmp;
-            elements[priorityQueues[whichQueue][which]].openLocation = which;
-            elements[priorityQueues[whichQueue][index]].openLocation = index;
-            HeapifyDown(which, whichQueue);
-        }
+    CmpKey0 compare;
+    int which;
+    unsigned int count = readyQueue.size();
+    // find smallest child
+    if (child1 >= count)
+        return;
+    else if (child2 >= count)
+        which = child1;
+    else if (!(compare(nodes.Keys(readyQueue[child1]), nodes.Keys(readyQueue[child2]))))
+        which = child1;
+    else
+        which = child2;
+
+    if (!(compare(nodes.Keys(readyQueue[which]), nodes.Keys(readyQueue[index])))) {
+        unsigned int tmp = readyQueue[which];
+        readyQueue[which] = readyQueue[index];
+        readyQueue[index] = tmp;
+        nodes.OpenLocation(readyQueue[which]) = which;
+        nodes.OpenLocation(readyQueue[index]) = index;
+        HeapifyDown(which);
     }
-
 }
 
 #endif
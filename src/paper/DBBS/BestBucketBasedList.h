@@ -11,22 +11,40 @@
 #include "BidirErrorBucketBasedList.h"
 #include "DBBS.h"
 
-template<typename state, class environment, class dataStructure = BucketNodeData<state>, MinCriterion criterion = MinCriterion::MinG>
-class BestBucketBasedList : public BidirErrorBucketBasedList<state, environment, dataStructure> {
+template<typename state, class environment, class dataStructure = BucketNodeData<state>,
+        MinCriterion criterion = MinCriterion::MinG, class bucketLayers = BucketMapLayers<state>>
+class BestBucketBasedList : public BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers> {
 
     using Bucket = std::vector<const state *>;
-    using BidirErrorBucketBasedList<state, environment, dataStructure>::fLayers;
-    using BidirErrorBucketBasedList<state, environment, dataStructure>::table;
+    using BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::fLayers;
+    using BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::table;
 
 
 public:
 
-    BestBucketBasedList() : BidirErrorBucketBasedList<state, environment, dataStructure>() {}
+    BestBucketBasedList() : BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>() {}
 
     ~BestBucketBasedList() {}
 
+    inline void Reset() {
+        BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::Reset();
+        invalidateCachedValues();
+        gLim = fLim = dLim = bLim = rfLim = rdLim = DBL_MAX;
+        foundCurrent = false;
+    }
+
     virtual bool AddOpenNode(const state val, double g, double h, double h_nx, const state *parent = nullptr);
 
+    inline bool RemoveIfEmpty(double g, double h, double h_nx) {
+        foundCurrent = false;
+        return BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::RemoveIfEmpty(g, h, h_nx);
+    }
+
+    inline const state *PopBucket(double g, double h, double h_nx) {
+        foundCurrent = false;
+        return BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::PopBucket(g, h, h_nx);
+    }
+
     std::pair<const state *, double> Pop();
 
     inline double getMinG() { return checkBestBucketAndReturnValue(minG); }
@@ -48,12 +66,19 @@ public:
     void computeBestBucket(double gLim_, double fLim_, double dLim_,
                            double bLim_, double rfLim_, double rdLim_);
 
+    /**
+     * Counts the entries of the buckets within the limits of the last computeBestBucket, which are already known if
+     * the list has not changed since
+     */
     void countExpandableNodes();
 
 private:
 
     Bucket *bestBucket = nullptr;
 
+    BestBucket<Bucket> found; // the result of the last computeBestBucket
+    bool foundCurrent = false; // whether the list has not changed since
+
     int expandableNodes = INT_MAX;
 
     double minG = DBL_MAX, minF = DBL_MAX, minD = DBL_MAX, minB = DBL_MAX, minRF = DBL_MAX, minRD = DBL_MAX;
@@ -81,13 +106,15 @@ private:
     bool useRC = true;
 };
 
-template<typename state, class environment, class dataStructure, MinCriterion criterion>
-bool BestBucketBasedList<state, environment, dataStructure, criterion>::AddOpenNode(const state val,
-                                                                                    const double g,
-                                                                                    const double h,
-                                                                                    const double h_nx,
-                                                                                    const state *parent) {
-    bool added = BidirErrorBucketBasedList<state, environment, dataStructure>::AddOpenNode(val, g, h, h_nx, parent);
+template<typename state, class environment, class dataStructure, MinCriterion criterion, class bucketLayers>
+bool BestBucketBasedList<state, environment, dataStructure, criterion, bucketLayers>::AddOpenNode(const state val,
+                                                                                                  const double g,
+                                                                                                  const double h,
+                                                                                                  const double h_nx,
+                                                                                                  const state *parent) {
+    using base = BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>;
+    bool added = base::AddOpenNode(val, g, h, h_nx, parent);
+    foundCurrent = false;
 
     const double f = g + h;
     const double d = g - h_nx;
@@ -101,117 +128,29 @@ bool BestBucketBasedList<state, environment, dataStructure, criterion>::AddOpenN
     return added;
 }
 
-template<typename state, class environment, class dataStructure, MinCriterion criterion>
-void BestBucketBasedList<state, environment, dataStructure, criterion>::computeBestBucket(double gLim_,
-                                                                                          double fLim_,
-                                                                                          double dLim_,
-                                                                                          double bLim_,
-                                                                                          double rfLim_,
-                                                                                          double rdLim_) {
+template<typename state, class environment, class dataStructure, MinCriterion criterion, class bucketLayers>
+void BestBucketBasedList<state, environment, dataStructure, criterion, bucketLayers>::computeBestBucket(double gLim_,
+                                                                                                        double fLim_,
+                                                                                                        double dLim_,
+                                                                                                        double bLim_,
+                                                                                                        double rfLim_,
+                                                                                                        double rdLim_) {
     invalidateCachedValues();
     gLim = gLim_, fLim = fLim_, dLim = dLim_, bLim = bLim_, rfLim = rfLim_, rdLim = rdLim_;
 
-    auto gLayerIt = fLayers.begin();
-    while (gLayerIt != fLayers.end()) {
-        double g = gLayerIt->first;
-
-        if (g > gLim) break;
-
-        auto &gLayer = gLayerIt->second;
-
-        if (gLayer.size() == 0) { // if the whole g layer is empty, erase it
-            gLayerIt = fLayers.erase(gLayerIt);
-            continue;
-        }
-
-        auto fLayerIt = gLayer.begin();
-        while (fLayerIt != gLayer.end()) {
-            double h = fLayerIt->first;
-            double f = g + h;
-
-            if (f > fLim) break;
+    // the layers erase the empty layers and buckets a scan under the limits reaches
+    found = BestBucket<Bucket>();
+    fLayers.FindBest(BucketLimits{gLim, fLim, dLim, bLim, rfLim, rdLim, useB, useRC}, found);
+    foundCurrent = true;
 
-            // check its rf value against rfLim
-            double rfValue = g - h;
-            if (useRC && rfValue > rfLim) {
-                fLayerIt++;
-                continue; // continue because rf is decreasing
-            }
-
-            auto &fLayer = fLayerIt->second;
-
-            if (fLayer.size() == 0) { // if the whole f layer is empty, erase it
-                fLayerIt = gLayer.erase(fLayerIt);
-                continue;
-            }
-
-            auto dLayerIt = fLayer.begin();
-            while (dLayerIt != fLayer.end()) {
-                double h_nx = dLayerIt->first;
-                double d = g - h_nx;
-
-                // deal with bucket - first, check that is not empty
-                Bucket &bucket = dLayerIt->second;
-                if (bucket.size() == 0) {
-                    dLayerIt = fLayer.erase(dLayerIt);
-                    continue;
-                }
-
-                if (d > dLim) break;
-
-                // check its b value against bLim
-                double bValue = f + d;
-                if (useB && bValue > bLim) {
-                    dLayerIt++;
-                    break;
-                }
-
-                // check its rd value against rdLim
-                double rdValue = g + h_nx;
-                if (useRC && rdValue > rdLim) {
-                    dLayerIt++;
-                    continue; // continue because rd is decreasing
-                }
-
-                // pick the bucket as best bucket if it is the best based on the criterion
-                if (g < minG) {
-                    minG = g;
-                    if (criterion == MinCriterion::MinG) bestBucket = &bucket;
-                }
-
-                if (f < minF) {
-                    minF = f;
-                    if (criterion == MinCriterion::MinF) bestBucket = &bucket;
-                }
-
-                if (d < minD) {
-                    minD = d;
-                    if (criterion == MinCriterion::MinD) bestBucket = &bucket;
-                }
-
-                if (useB && bValue < minB) {
-                    minB = bValue;
-                    if (criterion == MinCriterion::MinB) bestBucket = &bucket;
-                }
-
-                if (useRC && rfValue < minRF) {
-                    minRF = rfValue;
-                }
-
-                if (useRC && rdValue < minRD) {
-                    minRD = rdValue;
-                }
-
-                dLayerIt++;
-            }
-            fLayerIt++;
-        }
-        gLayerIt++;
-    }
+    minG = found.minG, minF = found.minF, minD = found.minD, minB = found.minB;
+    minRF = found.minRF, minRD = found.minRD;
+    bestBucket = found.best[criterion];
 }
 
-template<typename state, class environment, class dataStructure, MinCriterion criterion>
-std::pair<const state *, double> BestBucketBasedList<state, environment, dataStructure, criterion>::Pop() {
+template<typename state, class environment, class dataStructure, MinCriterion criterion, class bucketLayers>
+std::pair<const state *, double>
+BestBucketBasedList<state, environment, dataStructure, criterion, bucketLayers>::Pop() {
     const state *poppedState = nullptr;
 
     while (poppedState == nullptr) {
@@ -221,6 +160,8 @@ std::pair<const state *, double> BestBucketBasedList<state, environment, dataStr
 
         poppedState = bestBucket->back();
         bestBucket->pop_back();
+        fLayers.Popped(found, criterion);
+        foundCurrent = false;
         expandableNodes--;
         if (bestBucket->size() == 0)
             invalidateCachedValues(); // whenever a bucket is emptied, the cache must be invalidated
@@ -232,38 +173,40 @@ std::pair<const state *, double> BestBucketBasedList<state, environment, dataStr
 }
 
 
-template<typename state, class environment, class dataStructure, MinCriterion criterion>
-void BestBucketBasedList<state, environment, dataStructure, criterion>::countExpandableNodes() {
+template<typename state, class environment, class dataStructure, MinCriterion criterion, class bucketLayers>
+void BestBucketBasedList<state, environment, dataStructure, criterion, bucketLayers>::countExpandableNodes() {
 
-    expandableNodes = 0;
-    for (const auto &glayer: fLayers) {
-        double g = glayer.first;
-
-        if (g > gLim) break;
+    if (foundCurrent) {
+        expandableNodes = found.nodes;
+        return;
+    }
 
-        for (const auto &fLayer: glayer.second) {
-            double h = fLayer.first;
-            double f = g + h;
-            double rf = g - h;
+    expandableNodes = 0;
+    fLayers.template Scan<false>(
+            [&](double g) { return g <= gLim; },
+            [&](double g, double h) {
+                double f = g + h;
+                double rf = g - h;
 
-            if (f > fLim) break;
+                if (f > fLim) return LayerScan::Stop;
 
-            if (useRC && rf > rfLim) continue; // continue because rf is decreasing
+                if (useRC && rf > rfLim) return LayerScan::Skip; // continue because rf is decreasing
 
-            for (const auto &bucket: fLayer.second) {
-                double h_nx = bucket.first;
+                return LayerScan::Enter;
+            },
+            [&](double g, double h, double h_nx, const Bucket &bucket) {
+                double f = g + h;
                 double d = g - h_nx;
                 double rd = g + h_nx;
                 double b = f + d;
 
-                if (d > dLim || (useB && b > bLim)) break;
+                if (d > dLim || (useB && b > bLim)) return false;
 
-                if (useRC && rd > rdLim) continue; // continue because rd is decreasing
+                if (useRC && rd > rdLim) return true; // continue because rd is decreasing
 
-                expandableNodes += bucket.second.size();
-            }
-        }
-    }
+                expandableNodes += bucket.size();
+                return true;
+            });
 }
 
 
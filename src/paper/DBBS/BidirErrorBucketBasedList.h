@@ -11,6 +11,7 @@
 #include <climits>
 #include <functional>
 #include "BucketBasedList.h"
+#include "BucketLayers.h"
 #include "MinCriterion.h"
 
 struct NodeValues {
@@ -49,7 +50,11 @@ struct BucketHash {
     }
 };
 
-template<typename state, class environment, class dataStructure = BucketNodeData<state> >
+/**
+ * The buckets are kept in bucketLayers, see BucketLayers.h
+ */
+template<typename state, class environment, class dataStructure = BucketNodeData<state>,
+        class bucketLayers = BucketMapLayers<state>>
 class BidirErrorBucketBasedList {
 
 public:
@@ -60,14 +65,17 @@ public:
 
     ~BidirErrorBucketBasedList() {}
 
+    /**
+     * Remove all nodes. The storage of the buckets is kept for the next search, and the table keeps its buckets.
+     */
     inline void Reset() {
         table.clear();
-        fLayers.clear();
+        fLayers.Clear();
     }
 
     virtual bool AddOpenNode(const state val, double g, double h, double h_nx, const state *parent = nullptr);
 
-    bool IsEmpty() { return fLayers.size() == 0; }
+    bool IsEmpty() { return fLayers.Empty(); }
 
     bool RemoveIfEmpty(double g, double h, double h_nx);
 
@@ -97,6 +105,11 @@ public:
 
     inline void setEnvironment(environment *env_) { env = env_; }
 
+    /**
+     * The gcd of the edge costs, which the flat bucket layers index their costs by
+     */
+    inline void setGranularity(double gcd) { fLayers.SetGranularity(gcd); }
+
     std::vector<BucketInfo> getBucketInfo();
 
     NodeValues getNodeValues();
@@ -109,18 +122,16 @@ protected:
 
     std::unordered_map<const state, dataStructure, decltype(stateHasher)> table;
 
-    // fist key is g, second is h, third is h_nx (h_nx is sorted in reverse to traverse by ascending d)
-    std::map<double, std::map<double, std::map<double, Bucket, std::greater<double>> >>
-            fLayers;
+    bucketLayers fLayers;
 
 };
 
-template<typename state, class environment, class dataStructure>
-bool BidirErrorBucketBasedList<state, environment, dataStructure>::AddOpenNode(const state val,
-                                                                               const double g,
-                                                                               const double h,
-                                                                               const double h_nx,
-                                                                               const state *parent) {
+template<typename state, class environment, class dataStructure, class bucketLayers>
+bool BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::AddOpenNode(const state val,
+                                                                                             const double g,
+                                                                                             const double h,
+                                                                                             const double h_nx,
+                                                                                             const state *parent) {
     const double f = g + h;
     const double d = g - h_nx;
 
@@ -137,14 +148,14 @@ bool BidirErrorBucketBasedList<state, environment, dataStructure>::AddOpenNode(c
             }
 
             // invalidate pointer with higher g value in the open list
-            fLayers[old_g][h][h_nx][bucketIndex] = nullptr;
+            fLayers.Get(old_g, h, h_nx)[bucketIndex] = nullptr;
 
-            auto &bucket = fLayers[g][h][h_nx];
+            auto &bucket = fLayers.Get(g, h, h_nx);
             nodeIt->second = dataStructure(g, parent, bucket.size()); // node exists but with worse g value, update
             bucket.push_back(&(nodeIt->first));
         }
     } else {  // node doesn't exist
-        auto &bucket = fLayers[g][h][h_nx];
+        auto &bucket = fLayers.Get(g, h, h_nx);
         auto it_pair = table.insert(std::make_pair(val, dataStructure(g, parent, bucket.size())));
         bucket.push_back(&(it_pair.first->first));
     }
@@ -153,11 +164,11 @@ bool BidirErrorBucketBasedList<state, environment, dataStructure>::AddOpenNode(c
 
 }
 
-template<typename state, class environment, class dataStructure>
-bool BidirErrorBucketBasedList<state, environment, dataStructure>::RemoveIfEmpty(double g,
-                                                                                 double h,
-                                                                                 double h_nx) {
-    Bucket &bucket = fLayers[g][h][h_nx];
+template<typename state, class environment, class dataStructure, class bucketLayers>
+bool BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::RemoveIfEmpty(double g,
+                                                                                               double h,
+                                                                                               double h_nx) {
+    Bucket &bucket = fLayers.Get(g, h, h_nx);
 
     // remove erased entries to make sure that the bucket does not contain only invalid entries
     while (bucket.size() > 0 && bucket.back() == nullptr) {
@@ -169,26 +180,18 @@ bool BidirErrorBucketBasedList<state, environment, dataStructure>::RemoveIfEmpty
     // delete empty dimensions
     if (bucket.size() == 0) {
         bucketEmptied = true;
-        auto &fLayer = fLayers[g][h];
-        fLayer.erase(h_nx);
-        if (fLayer.size() == 0) {
-            auto &gLayer = fLayers[g];
-            gLayer.erase(h);
-            if (gLayer.size() == 0) {
-                fLayers.erase(g);
-            }
-        }
+        fLayers.Erase(g, h, h_nx);
     }
 
     return bucketEmptied;
 }
 
-template<typename state, class environment, class dataStructure>
-const state *BidirErrorBucketBasedList<state, environment, dataStructure>::PopBucket(double g,
-                                                                                     double h,
-                                                                                     double h_nx) {
+template<typename state, class environment, class dataStructure, class bucketLayers>
+const state *BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::PopBucket(double g,
+                                                                                                   double h,
+                                                                                                   double h_nx) {
     // pop state - it has to be a proper bucket, so call RemoveIfInvalid if needed
-    Bucket &bucket = fLayers[g][h][h_nx];
+    Bucket &bucket = fLayers.Get(g, h, h_nx);
     const state *poppedState = bucket.back();
     bucket.pop_back();
     RemoveIfEmpty(g, h, h_nx); // remove if it is empty
@@ -200,56 +203,53 @@ const state *BidirErrorBucketBasedList<state, environment, dataStructure>::PopBu
     return poppedState;
 }
 
-template<typename state, class environment, class dataStructure>
-std::vector<BucketInfo> BidirErrorBucketBasedList<state, environment, dataStructure>::getBucketInfo() {
+template<typename state, class environment, class dataStructure, class bucketLayers>
+std::vector<BucketInfo> BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::getBucketInfo() {
 
     std::vector<BucketInfo> result;
 
-    for (const auto &glayer: fLayers) {
-        double g = glayer.first;
-        for (const auto &fLayer: glayer.second) {
-            double h = fLayer.first;
-            for (const auto &bucket: fLayer.second) {
-                double h_nx = bucket.first;
-                result.push_back(BucketInfo(g, h, h_nx, bucket.second.size()));
+    fLayers.template Scan<false>(
+            [](double) { return true; },
+            [](double, double) { return LayerScan::Enter; },
+            [&](double g, double h, double h_nx, const Bucket &bucket) {
+                result.push_back(BucketInfo(g, h, h_nx, bucket.size()));
 
                 // TODO check if this optimization is useful enough to be enabled
                 // if (!useRC) break; // subsequent buckets will be dominated if RC is not used
-            }
-        }
-    }
+                return true;
+            });
 
     return result;
 
 }
 
-template<typename state, class environment, class dataStructure>
-NodeValues BidirErrorBucketBasedList<state, environment, dataStructure>::getNodeValues() {
+template<typename state, class environment, class dataStructure, class bucketLayers>
+NodeValues BidirErrorBucketBasedList<state, environment, dataStructure, bucketLayers>::getNodeValues() {
 
     NodeValues result;
 
-    for (const auto &glayer: fLayers) {
-        double g = glayer.first;
-        result.g_values.insert(g);
-
-        for (const auto &fLayer: glayer.second) {
-            double h = fLayer.first;
-            double f = g + h;
-            double rf = g - h;
-            result.f_values.insert(f);
-            result.rf_values.insert(rf);
-
-            for (const auto &bucket: fLayer.second) {
-                double h_nx = bucket.first;
+    fLayers.template Scan<false>(
+            [&](double g) {
+                result.g_values.insert(g);
+                return true;
+            },
+            [&](double g, double h) {
+                double f = g + h;
+                double rf = g - h;
+                result.f_values.insert(f);
+                result.rf_values.insert(rf);
+                return LayerScan::Enter;
+            },
+            [&](double g, double h, double h_nx, const Bucket &) {
+                double f = g + h;
                 double d = g - h_nx;
                 double rd = g + h_nx;
                 double b = f + d;
                 result.d_values.insert(d);
                 result.rd_values.insert(rd);
                 result.b_values.insert(b);
-            }
-        }
-    }
+                return true;
+            });
 
     return result;
 }
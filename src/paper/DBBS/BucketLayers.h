@@ -0,0 +1,614 @@
+#ifndef BUCKETLAYERS_H
+#define BUCKETLAYERS_H
+
+#include <cfloat>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include "MinCriterion.h"
+
+/**
+ * What a scan over the layers does with a (g, h) layer
+ */
+enum class LayerScan {
+    Enter, // visit its buckets
+    Skip,  // go on with the next h of the same g
+    Stop   // go on with the next g
+};
+
+/**
+ * The largest values of the buckets that can be expanded. The b, rf and rd limits only apply when useB and useRC are
+ * set.
+ */
+struct BucketLimits {
+    double g, f, d, b, rf, rd;
+    bool useB, useRC;
+
+    bool operator==(const BucketLimits &other) const {
+        return g == other.g && f == other.f && d == other.d && b == other.b && rf == other.rf && rd == other.rd
+               && useB == other.useB && useRC == other.useRC;
+    }
+
+    /**
+     * Whether the buckets of a (g, h) layer may be within the limits. The f of the next layers only grows and their rf
+     * only shrinks.
+     */
+    inline LayerScan Layer(double g, double h) const {
+        if (g + h > f) return LayerScan::Stop;
+        if (useRC && g - h > rf) return LayerScan::Skip;
+        return LayerScan::Enter;
+    }
+};
+
+/**
+ * The smallest values over the non-empty buckets within some limits, found by visiting them in the order of the scans.
+ * For every criterion, best holds the first bucket with its smallest value, and where holds the position of that
+ * bucket, for the layers which need it to follow the changes of the bucket.
+ */
+template<class Bucket>
+struct BestBucket {
+    double minG = DBL_MAX, minF = DBL_MAX, minD = DBL_MAX, minB = DBL_MAX, minRF = DBL_MAX, minRD = DBL_MAX;
+    Bucket *best[4] = {nullptr, nullptr, nullptr, nullptr};
+    size_t where[4] = {0, 0, 0, 0};
+    int nodes = 0; // entries of the buckets within the limits, including the invalidated ones
+
+    /**
+     * Adds a bucket of a layer within the limits, and returns false when the next buckets of the layer, which have a
+     * larger d and b, are over the limits.
+     */
+    inline bool Visit(const BucketLimits &limits, double g, double h, double h_nx, Bucket &bucket) {
+        double f = g + h;
+        double d = g - h_nx;
+
+        if (d > limits.d) return false;
+
+        // check its b value against bLim
+        double bValue = f + d;
+        if (limits.useB && bValue > limits.b) return false;
+
+        // check its rd value against rdLim
+        double rdValue = g + h_nx;
+        if (limits.useRC && rdValue > limits.rd) return true; // continue because rd is decreasing
+
+        double rfValue = g - h;
+
+        if (g < minG) {
+            minG = g;
+            best[MinG] = &bucket;
+        }
+
+        if (f < minF) {
+            minF = f;
+            best[MinF] = &bucket;
+        }
+
+        if (d < minD) {
+            minD = d;
+            best[MinD] = &bucket;
+        }
+
+        if (limits.useB && bValue < minB) {
+            minB = bValue;
+            best[MinB] = &bucket;
+        }
+
+        if (limits.useRC && rfValue < minRF) {
+            minRF = rfValue;
+        }
+
+        if (limits.useRC && rdValue < minRD) {
+            minRD = rdValue;
+        }
+
+        nodes += bucket.size();
+        return true;
+    }
+
+    /**
+     * Adds the buckets of a later part of the scan
+     */
+    void Merge(const BestBucket &other) {
+        double *mins[4] = {&minG, &minF, &minD, &minB};
+        const double *otherMins[4] = {&other.minG, &other.minF, &other.minD, &other.minB};
+        for (int criterion = 0; criterion < 4; criterion++) {
+            if (*otherMins[criterion] < *mins[criterion]) {
+                *mins[criterion] = *otherMins[criterion];
+                best[criterion] = other.best[criterion];
+                where[criterion] = other.where[criterion];
+            }
+        }
+        minRF = std::min(minRF, other.minRF);
+        minRD = std::min(minRD, other.minRD);
+        nodes += other.nodes;
+    }
+};
+
+/**
+ * The buckets of BidirErrorBucketBasedList, by g, then h, then h_nx. The containers keep the same layers, including
+ * the empty ones, which are only erased by Erase or by a pruning scan that reaches them, as the list relies on it.
+ *
+ * Scan<prune>(visitG, visitH, visitBucket) visits the layers by ascending g, ascending h and descending h_nx (ascending
+ * d). visitG(g) returns false to end the scan, visitH(g, h) returns a LayerScan and visitBucket(g, h, h_nx, bucket)
+ * returns false to leave the (g, h) layer. A pruning scan erases the empty layers and buckets it reaches instead of
+ * visiting them.
+ *
+ * FindBest(limits, best) adds the buckets within the limits to best, erasing the empty layers and buckets as a pruning
+ * scan over them would, and Popped(best, criterion) tells the layers that an entry was taken from the best bucket of
+ * the criterion.
+ */
+template<typename state>
+class BucketMapLayers {
+public:
+
+    using Bucket = std::vector<const state *>;
+
+    /**
+     * The layers are keyed by their exact values, so the granularity of the costs is not needed
+     */
+    inline void SetGranularity(double) {}
+
+    inline bool Empty() const { return fLayers.size() == 0; }
+
+    /**
+     * Returns the bucket of the given values, creating it if needed. A new bucket takes over the storage of a
+     * recycled one when available.
+     */
+    inline Bucket &Get(double g, double h, double h_nx) {
+        Bucket &bucket = fLayers[g][h][h_nx];
+        if (bucket.capacity() == 0 && !spareBuckets.empty()) {
+            bucket.swap(spareBuckets.back());
+            spareBuckets.pop_back();
+        }
+        return bucket;
+    }
+
+    /**
+     * Erases a bucket, and its (g, h) and g layers if they are left empty
+     */
+    void Erase(double g, double h, double h_nx) {
+        RecycleBucket(fLayers[g][h][h_nx]);
+        auto &fLayer = fLayers[g][h];
+        fLayer.erase(h_nx);
+        if (fLayer.size() == 0) {
+            auto &gLayer = fLayers[g];
+            gLayer.erase(h);
+            if (gLayer.size() == 0) {
+                fLayers.erase(g);
+            }
+        }
+    }
+
+    /**
+     * Remove all the buckets, keeping their storage for the next search
+     */
+    void Clear() {
+        for (auto &gLayer: fLayers)
+            for (auto &fLayer: gLayer.second)
+                for (auto &bucket: fLayer.second)
+                    RecycleBucket(bucket.second);
+        fLayers.clear();
+    }
+
+    template<bool prune, class gVisitor, class hVisitor, class bucketVisitor>
+    void Scan(gVisitor visitG, hVisitor visitH, bucketVisitor visitBucket) {
+        auto gLayerIt = fLayers.begin();
+        while (gLayerIt != fLayers.end()) {
+            double g = gLayerIt->first;
+
+            if (!visitG(g)) break;
+
+            auto &gLayer = gLayerIt->second;
+
+            if (prune && gLayer.size() == 0) { // if the whole g layer is empty, erase it
+                gLayerIt = fLayers.erase(gLayerIt);
+                continue;
+            }
+
+            auto fLayerIt = gLayer.begin();
+            while (fLayerIt != gLayer.end()) {
+                double h = fLayerIt->first;
+
+                LayerScan next = visitH(g, h);
+                if (next == LayerScan::Stop) break;
+                if (next == LayerScan::Skip) {
+                    fLayerIt++;
+                    continue;
+                }
+
+                auto &fLayer = fLayerIt->second;
+
+                if (prune && fLayer.size() == 0) { // if the whole f layer is empty, erase it
+                    fLayerIt = gLayer.erase(fLayerIt);
+                    continue;
+                }
+
+                auto dLayerIt = fLayer.begin();
+                while (dLayerIt != fLayer.end()) {
+                    Bucket &bucket = dLayerIt->second;
+                    if (prune && bucket.size() == 0) {
+                        RecycleBucket(bucket);
+                        dLayerIt = fLayer.erase(dLayerIt);
+                        continue;
+                    }
+
+                    if (!visitBucket(g, h, dLayerIt->first, bucket)) break;
+
+                    dLayerIt++;
+                }
+                fLayerIt++;
+            }
+            gLayerIt++;
+        }
+    }
+
+    void FindBest(const BucketLimits &limits, BestBucket<Bucket> &best) {
+        Scan<true>([&](double g) { return g <= limits.g; },
+                   [&](double g, double h) { return limits.Layer(g, h); },
+                   [&](double g, double h, double h_nx, Bucket &bucket) {
+                       return best.Visit(limits, g, h, h_nx, bucket);
+                   });
+    }
+
+    inline void Popped(const BestBucket<Bucket> &, MinCriterion) {}
+
+private:
+
+    /**
+     * Keeps the storage of a bucket that is about to be erased, so it can be reused by Get
+     */
+    inline void RecycleBucket(Bucket &bucket) {
+        if (bucket.capacity() == 0)
+            return;
+        bucket.clear();
+        spareBuckets.push_back(std::move(bucket));
+    }
+
+    // fist key is g, second is h, third is h_nx (h_nx is sorted in reverse to traverse by ascending d)
+    std::map<double, std::map<double, std::map<double, Bucket, std::greater<double>> >> fLayers;
+
+    std::vector<Bucket> spareBuckets;
+};
+
+/**
+ * The same layers in flat arrays, for costs that are multiples of a known granularity (the gcd of the edge costs).
+ *
+ * The g layers are rows indexed by g / gcd, and a bitmap of the present rows lets a scan jump over the missing ones.
+ * A row keeps its (g, h) layers in a vector sorted by h, so that a scan reads them in order from contiguous memory, and
+ * a (g, h) layer keeps its few h_nx in a small vector, sorted by descending h_nx. The buckets are kept in a deque, so
+ * that a bucket does not move while others are added, and an erased one is reused with its storage.
+ *
+ * A search with BestBucketBasedList looks for the best bucket under the same few limits over and over, while each
+ * expansion only changes a few rows. So FindBest keeps the result of every row, and of every block of kBlockRows rows,
+ * for the last kRecentLimits limits it was given, with the version of the row or block it was found at. It only scans
+ * again the rows that changed since, and merges the results kept for the blocks that did not. A scan which erased
+ * anything is not kept, as scanning it again erases the layers it left empty.
+ */
+template<typename state>
+class BucketGridLayers {
+public:
+
+    using Bucket = std::vector<const state *>;
+
+    inline void SetGranularity(double gcd_) { gcd = gcd_; }
+
+    inline bool Empty() const { return presentRows == 0; }
+
+    Bucket &Get(double g, double h, double h_nx) {
+        size_t gIndex = Index(g);
+        if (gIndex >= rows.size()) {
+            rows.resize(gIndex + 1);
+            rowBits.resize(rows.size() / 64 + 1, 0);
+            blocks.resize(rows.size() / kBlockRows + 1);
+        }
+        Row &row = rows[gIndex];
+        Changed(gIndex); // the bucket is about to change
+        if (!TestBit(rowBits, gIndex)) {
+            SetBit(rowBits, gIndex);
+            presentRows++;
+            row.g = g;
+        }
+
+        auto layerIt = FindLayer(row, h);
+        if (layerIt == row.layers.end() || layerIt->h != h) {
+            layerIt = row.layers.emplace(layerIt);
+            layerIt->h = h;
+        }
+
+        auto &entries = layerIt->buckets;
+        auto it = std::lower_bound(entries.begin(), entries.end(), h_nx,
+                                   [](const std::pair<double, Bucket *> &entry, double value) {
+                                       return entry.first > value;
+                                   });
+        if (it != entries.end() && it->first == h_nx)
+            return *it->second;
+
+        Bucket *bucket;
+        if (spareBuckets.empty()) {
+            buckets.emplace_back();
+            bucket = &buckets.back();
+        } else {
+            bucket = spareBuckets.back();
+            spareBuckets.pop_back();
+        }
+        entries.insert(it, std::make_pair(h_nx, bucket));
+        return *bucket;
+    }
+
+    void Erase(double g, double h, double h_nx) {
+        size_t gIndex = Index(g);
+        Row &row = rows[gIndex];
+        Changed(gIndex);
+        auto layerIt = FindLayer(row, h);
+        auto &entries = layerIt->buckets;
+        for (auto it = entries.begin(); it != entries.end(); it++) {
+            if (it->first == h_nx) {
+                RecycleBucket(it->second);
+                entries.erase(it);
+                break;
+            }
+        }
+        if (entries.empty()) {
+            row.layers.erase(layerIt);
+            if (row.layers.empty())
+                EraseRow(gIndex);
+        }
+    }
+
+    void Clear() {
+        ForEachBit(rowBits, [&](size_t gIndex) {
+            Row &row = rows[gIndex];
+            for (auto &layer: row.layers)
+                for (auto &entry: layer.buckets)
+                    RecycleBucket(entry.second);
+            row.layers.clear();
+            Changed(gIndex);
+            EraseRow(gIndex);
+            return true;
+        });
+    }
+
+    template<bool prune, class gVisitor, class hVisitor, class bucketVisitor>
+    void Scan(gVisitor visitG, hVisitor visitH, bucketVisitor visitBucket) {
+        ForEachBit(rowBits, [&](size_t gIndex) {
+            if (!visitG(rows[gIndex].g)) return false;
+            if (ScanRow<prune>(gIndex, visitH, visitBucket))
+                Changed(gIndex);
+            return true;
+        });
+    }
+
+    void FindBest(const BucketLimits &limits, BestBucket<Bucket> &best) {
+        size_t slot = LimitsSlot(limits);
+        for (size_t block = 0; block < blocks.size(); block++) {
+            uint64_t present = BlockBits(block);
+            if (present == 0) continue;
+            if (!(rows[block * kBlockRows + __builtin_ctzll(present)].g <= limits.g)) break;
+
+            KeptBest &kept = blocks[block].best[slot];
+            if (kept.epoch != epochs[slot] || kept.version != blocks[block].version) {
+                BestBucket<Bucket> blockBest;
+                bool erased = false;
+                while (present != 0) {
+                    size_t gIndex = block * kBlockRows + __builtin_ctzll(present);
+                    present &= present - 1;
+                    if (!(rows[gIndex].g <= limits.g)) break;
+                    erased |= FindRowBest(gIndex, slot, limits, blockBest);
+                }
+                kept.epoch = erased ? 0 : epochs[slot];
+                kept.version = blocks[block].version;
+                kept.best = blockBest;
+            }
+            best.Merge(kept.best);
+        }
+    }
+
+    /**
+     * An entry taken from a bucket changes the results kept for its row
+     */
+    inline void Popped(const BestBucket<Bucket> &best, MinCriterion criterion) { Changed(best.where[criterion]); }
+
+private:
+
+    static const int kRecentLimits = 8;
+    static const int kBlockRows = 16;
+
+    /**
+     * A (g, h) layer, with the bucket of each h_nx
+     */
+    struct Layer {
+        double h;
+        std::vector<std::pair<double, Bucket *>> buckets;
+    };
+
+    /**
+     * The best buckets of a row or block under the limits of a slot of recentLimits, while epoch is the epoch of the
+     * slot and version is the version of the row or block
+     */
+    struct KeptBest {
+        uint64_t epoch = 0;
+        uint64_t version = 0;
+        BestBucket<Bucket> best;
+    };
+
+    struct Row {
+        double g = 0;
+        uint64_t version = 0; // changes with every change of the row
+        std::vector<Layer> layers;
+        KeptBest best[kRecentLimits];
+    };
+
+    struct Block {
+        uint64_t version = 0; // changes with every change of its rows
+        KeptBest best[kRecentLimits];
+    };
+
+    inline size_t Index(double value) const { return static_cast<size_t>(value / gcd + 0.5); }
+
+    inline void Changed(size_t gIndex) {
+        rows[gIndex].version++;
+        blocks[gIndex / kBlockRows].version++;
+    }
+
+    /**
+     * The bits of the present rows of a block
+     */
+    inline uint64_t BlockBits(size_t block) const {
+        return (rowBits[block * kBlockRows / 64] >> (block * kBlockRows % 64)) & ((uint64_t(1) << kBlockRows) - 1);
+    }
+
+    /**
+     * Adds the buckets of a row within the limits of a slot to best, from the result kept for the row if it did not
+     * change since, and returns whether its scan erased anything
+     */
+    bool FindRowBest(size_t gIndex, size_t slot, const BucketLimits &limits, BestBucket<Bucket> &best) {
+        Row &row = rows[gIndex];
+        KeptBest &kept = row.best[slot];
+        bool erased = false;
+        if (kept.epoch != epochs[slot] || kept.version != row.version) {
+            BestBucket<Bucket> rowBest;
+            erased = ScanRow<true>(gIndex,
+                                   [&](double g, double h) { return limits.Layer(g, h); },
+                                   [&](double g, double h, double h_nx, Bucket &bucket) {
+                                       return rowBest.Visit(limits, g, h, h_nx, bucket);
+                                   });
+            if (erased)
+                Changed(gIndex);
+            std::fill(rowBest.where, rowBest.where + 4, gIndex);
+            kept.epoch = erased ? 0 : epochs[slot]; // scan it again if it erased anything
+            kept.version = row.version;
+            kept.best = rowBest;
+        }
+        best.Merge(kept.best);
+        return erased;
+    }
+
+    static inline typename std::vector<Layer>::iterator FindLayer(Row &row, double h) {
+        return std::lower_bound(row.layers.begin(), row.layers.end(), h,
+                                [](const Layer &layer, double value) { return layer.h < value; });
+    }
+
+    /**
+     * The slot of recentLimits holding the limits, replacing the least recently used one if none does
+     */
+    size_t LimitsSlot(const BucketLimits &limits) {
+        size_t slot = 0;
+        for (size_t i = 0; i < kRecentLimits; i++) {
+            if (epochs[i] != 0 && recentLimits[i] == limits) {
+                lastUse[i] = ++uses;
+                return i;
+            }
+            if (lastUse[i] < lastUse[slot])
+                slot = i;
+        }
+        recentLimits[slot] = limits;
+        epochs[slot] = ++lastEpoch; // the results kept for the previous limits of the slot are no longer valid
+        lastUse[slot] = ++uses;
+        return slot;
+    }
+
+    /**
+     * Visits the layers of a row, as Scan does, and returns whether a pruning scan erased anything
+     */
+    template<bool prune, class hVisitor, class bucketVisitor>
+    bool ScanRow(size_t gIndex, hVisitor visitH, bucketVisitor visitBucket) {
+        Row &row = rows[gIndex];
+        double g = row.g;
+        auto &layers = row.layers;
+        bool erased = false;
+
+        if (prune && layers.empty()) { // if the whole g layer is empty, erase it
+            EraseRow(gIndex);
+            return true;
+        }
+
+        auto layerIt = layers.begin();
+        while (layerIt != layers.end()) {
+            double h = layerIt->h;
+
+            LayerScan next = visitH(g, h);
+            if (next == LayerScan::Stop) break;
+            if (next == LayerScan::Skip) {
+                layerIt++;
+                continue;
+            }
+
+            auto &entries = layerIt->buckets;
+
+            if (prune && entries.empty()) { // if the whole f layer is empty, erase it
+                layerIt = layers.erase(layerIt);
+                erased = true;
+                continue;
+            }
+
+            auto it = entries.begin();
+            while (it != entries.end()) {
+                Bucket &bucket = *it->second;
+                if (prune && bucket.size() == 0) {
+                    RecycleBucket(&bucket);
+                    it = entries.erase(it);
+                    erased = true;
+                    continue;
+                }
+
+                if (!visitBucket(g, h, it->first, bucket)) break;
+
+                it++;
+            }
+            layerIt++;
+        }
+        return erased;
+    }
+
+    static inline bool TestBit(const std::vector<uint64_t> &bits, size_t i) { return (bits[i >> 6] >> (i & 63)) & 1; }
+
+    static inline void SetBit(std::vector<uint64_t> &bits, size_t i) { bits[i >> 6] |= uint64_t(1) << (i & 63); }
+
+    static inline void ClearBit(std::vector<uint64_t> &bits, size_t i) { bits[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    /**
+     * Calls visit with the index of each set bit in ascending order, until it returns false. The bits of the word being
+     * visited are read once, so visit may clear the bit it is given.
+     */
+    template<class visitor>
+    static void ForEachBit(const std::vector<uint64_t> &bits, visitor visit) {
+        for (size_t word = 0; word < bits.size(); word++) {
+            uint64_t remaining = bits[word];
+            while (remaining != 0) {
+                size_t i = (word << 6) + __builtin_ctzll(remaining);
+                remaining &= remaining - 1;
+                if (!visit(i)) return;
+            }
+        }
+    }
+
+    inline void EraseRow(size_t gIndex) {
+        ClearBit(rowBits, gIndex);
+        presentRows--;
+    }
+
+    inline void RecycleBucket(Bucket *bucket) {
+        bucket->clear();
+        spareBuckets.push_back(bucket);
+    }
+
+    double gcd = 1.0;
+
+    std::vector<Row> rows;
+    std::vector<Block> blocks;
+    std::vector<uint64_t> rowBits;
+    size_t presentRows = 0;
+
+    std::deque<Bucket> buckets;
+    std::vector<Bucket *> spareBuckets;
+
+    BucketLimits recentLimits[kRecentLimits];
+    uint64_t epochs[kRecentLimits] = {}; // 0 while a slot holds no limits
+    uint64_t lastUse[kRecentLimits] = {};
+    uint64_t lastEpoch = 0, uses = 0;
+};
+
+#endif //BUCKETLAYERS_H
@@ -5,10 +5,14 @@
 #include "FrontToEnd.h"
 #include "FPUtil.h"
 #include <iostream>
+#include <iterator>
 #include <math.h>
+#include <set>
 #include "MinCriterion.h"
+#include "DirectionPolicy.h"
 
-template<class state, class action, class environment, MinCriterion criterion, class priorityQueue = BestBucketBasedList<state, environment, BucketNodeData<state>, criterion>>
+template<class state, class action, class environment, MinCriterion criterion, class direction = AlternatingDirection,
+        class priorityQueue = BestBucketBasedList<state, environment, BucketNodeData<state>, criterion>>
 class DBBS : public FrontToEnd<state, action, environment, priorityQueue> {
 
     using FrontToEnd<state, action, environment, priorityQueue>::forwardQueue;
@@ -21,6 +25,8 @@ class DBBS : public FrontToEnd<state, action, environment, priorityQueue> {
     using FrontToEnd<state, action, environment, priorityQueue>::start;
     using FrontToEnd<state, action, environment, priorityQueue>::goal;
     using FrontToEnd<state, action, environment, priorityQueue>::nodesExpanded;
+    using FrontToEnd<state, action, environment, priorityQueue>::nodesTouched;
+    using FrontToEnd<state, action, environment, priorityQueue>::limiter;
 
     using FrontToEnd<state, action, environment, priorityQueue>::Expand;
     using FrontToEnd<state, action, environment, priorityQueue>::ExpandBucket;
@@ -28,20 +34,67 @@ class DBBS : public FrontToEnd<state, action, environment, priorityQueue> {
 
 
 public:
-    DBBS(bool alternating_, bool useB_ = true, double epsilon_ = 1.0, double gcd_ = 1.0)
-            : FrontToEnd<state, action, environment, priorityQueue>(epsilon_),
-              alternating(alternating_), useB(useB_), gcd(gcd_) {}
+    /**
+     * The side-choosing policy is the direction template parameter, see DirectionPolicy.h
+     */
+    DBBS(bool useB_ = true, double epsilon_ = 1.0, double gcd_ = 1.0)
+            : FrontToEnd<state, action, environment, priorityQueue>(epsilon_), useB(useB_), gcd(gcd_) {
+        forwardQueue.setGranularity(gcd);
+        backwardQueue.setGranularity(gcd);
+    }
 
     ~DBBS() {}
 
     virtual const char *GetName() { return "DBBS"; }
 
+    const direction &GetDirectionPolicy() const { return directionPolicy; }
+
 protected:
+    /**
+     * The view of the two sides given to the direction policy. The next node of a side is in its best bucket, so the
+     * open size is the number of nodes that can be expanded from it.
+     */
+    class Sides {
+    public:
+        Sides(priorityQueue &forward_, priorityQueue &backward_, const uint64_t *expansions_, uint64_t generated_)
+                : forwardQueue(forward_), backwardQueue(backward_), expansions(expansions_), generated(generated_) {}
+
+        int OpenSize(bool forward) const { return Queue(forward).getExpandableNodes(); }
+
+        double TopB(bool forward) const { return Computed(forward) ? Queue(forward).getMinB() : DBL_MAX; }
+
+        double TopF(bool forward) const { return Computed(forward) ? Queue(forward).getMinF() : DBL_MAX; }
+
+        double TopG(bool forward) const { return Computed(forward) ? Queue(forward).getMinG() : DBL_MAX; }
+
+        uint64_t Expansions(bool forward) const { return expansions[forward ? 0 : 1]; }
+
+        uint64_t Generated() const { return generated; }
+
+    private:
+        priorityQueue &Queue(bool forward) const { return forward ? forwardQueue : backwardQueue; }
+
+        bool Computed(bool forward) const { return Queue(forward).isBestBucketComputed(); }
+
+        priorityQueue &forwardQueue;
+        priorityQueue &backwardQueue;
+        const uint64_t *expansions;
+        uint64_t generated;
+    };
 
     bool UpdateC();
 
     double GetNextC();
 
+    /**
+     * @return The smallest bound(x, y) above C over the pairs of a value x of one side and a value y of the other, or
+     * result if it is smaller. The bound must not decrease when x or y grows, so the smallest y for which it is above C
+     * only moves down as x grows, and both sorted sets are swept once instead of trying every pair.
+     */
+    template<class pairBound>
+    double SmallestBoundAbove(const std::set<double> &xs, const std::set<double> &ys, pairBound bound,
+                              double result) const;
+
     virtual void RunAlgorithm();
 
     void ExpandFromBestBucket(priorityQueue &current, priorityQueue &opposite,
@@ -49,19 +102,19 @@ protected:
                               Heuristic<state> *reverseHeuristic,
                               const state &target, const state &source);
 
-    bool alternating;
     bool useB;
     double gcd;
 
-    bool expandForward = true;
+    direction directionPolicy; // Chooses the side of every expansion
+    uint64_t sideExpansions[2] = {0, 0}; // Number of expansions on the forward and backward sides
 
 
     // TODO parametrize this
     bool useRC = true;
 };
 
-template<class state, class action, class environment, MinCriterion criterion, class priorityQueue>
-bool DBBS<state, action, environment, criterion, priorityQueue>::UpdateC() {
+template<class state, class action, class environment, MinCriterion criterion, class direction, class priorityQueue>
+bool DBBS<state, action, environment, criterion, direction, priorityQueue>::UpdateC() {
 
     if (forwardQueue.isBestBucketComputed() && backwardQueue.isBestBucketComputed())
         return false; // no need to recompute anything, and no need to rise C
@@ -126,8 +179,8 @@ bool DBBS<state, action, environment, criterion, priorityQueue>::UpdateC() {
         }
     }
 
-    // if we don't alternate, count nodes on both sides
-    if (!alternating && forwardQueue.isBestBucketComputed() && backwardQueue.isBestBucketComputed()) {
+    // count nodes on both sides, only if the direction policy reads them
+    if (direction::kUsesOpenSizes && forwardQueue.isBestBucketComputed() && backwardQueue.isBestBucketComputed()) {
         forwardQueue.countExpandableNodes();
         backwardQueue.countExpandableNodes();
     }
@@ -135,8 +188,8 @@ bool DBBS<state, action, environment, criterion, priorityQueue>::UpdateC() {
     return incrementedC;
 }
 
-template<class state, class action, class environment, MinCriterion criterion, class priorityQueue>
-double DBBS<state, action, environment, criterion, priorityQueue>::GetNextC() {
+template<class state, class action, class environment, MinCriterion criterion, class direction, class priorityQueue>
+double DBBS<state, action, environment, criterion, direction, priorityQueue>::GetNextC() {
 
     // TODO figure out if using more bounds may make increasing C slower
 
@@ -146,114 +199,80 @@ double DBBS<state, action, environment, criterion, priorityQueue>::GetNextC() {
     const NodeValues &backwardValues = backwardQueue.getNodeValues();
 
     // g bound
-    const auto &forward_g_values = forwardValues.g_values;
-    const auto &backward_g_values = backwardValues.g_values;
-
-    for (const double fw_g_value: forward_g_values)
-        for (const double bw_g_value: backward_g_values) {
-            double g_bound = fw_g_value + bw_g_value + epsilon;
-            if (g_bound > C && g_bound < result)
-                result = g_bound;
-        }
+    result = SmallestBoundAbove(forwardValues.g_values, backwardValues.g_values,
+                                [this](double fw_g_value, double bw_g_value) {
+                                    return fw_g_value + bw_g_value + epsilon;
+                                }, result);
 
-    const auto &forward_f_values = forwardValues.f_values;
-    const auto &forward_d_values = forwardValues.d_values;
-    const auto &backward_f_values = backwardValues.f_values;
-    const auto &backward_d_values = backwardValues.d_values;
+    auto sum = [](double value1, double value2) { return value1 + value2; };
 
     // forward KK bound
-    for (const double fw_f_value: forward_f_values)
-        for (const double bw_d_value: backward_d_values) {
-            double fw_KK_bound = fw_f_value + bw_d_value;
-            if (fw_KK_bound > C && fw_KK_bound < result)
-                result = fw_KK_bound;
-        }
+    result = SmallestBoundAbove(forwardValues.f_values, backwardValues.d_values, sum, result);
 
     // backward KK bound
-    for (const double bw_f_value: backward_f_values)
-        for (const double fw_d_value: forward_d_values) {
-            double bw_KK_bound = bw_f_value + fw_d_value;
-            if (bw_KK_bound > C && bw_KK_bound < result)
-                result = bw_KK_bound;
-        }
+    result = SmallestBoundAbove(backwardValues.f_values, forwardValues.d_values, sum, result);
 
     // b bound
     if (useB) {
-        const auto &forward_b_values = forwardValues.b_values;
-        const auto &backward_b_values = backwardValues.b_values;
-
-        for (const double fw_b_value: forward_b_values)
-            for (const double bw_b_value: backward_b_values) {
-                double b_bound = gcd * std::ceil(((fw_b_value + bw_b_value) / 2) / gcd);
-                if (b_bound > C && b_bound < result)
-                    result = b_bound;
-            }
+        result = SmallestBoundAbove(forwardValues.b_values, backwardValues.b_values,
+                                    [this](double fw_b_value, double bw_b_value) {
+                                        return gcd * std::ceil(((fw_b_value + bw_b_value) / 2) / gcd);
+                                    }, result);
     }
 
-    // forward rc bound
+    // forward and backward rc bounds
     if (useRC) {
-        const auto &forward_rf_values = forwardValues.rf_values;
-        const auto &backward_rd_values = backwardValues.rd_values;
-
-        for (const double fw_rf_value: forward_rf_values)
-            for (const double bw_rd_value: backward_rd_values) {
-                double fw_RC_bound = fw_rf_value + bw_rd_value;
-                if (fw_RC_bound > C && fw_RC_bound < result)
-                    result = fw_RC_bound;
-            }
+        result = SmallestBoundAbove(forwardValues.rf_values, backwardValues.rd_values, sum, result);
+        result = SmallestBoundAbove(backwardValues.rf_values, forwardValues.rd_values, sum, result);
     }
 
-    // backward rc bound
-    if (useRC) {
-        const auto &forward_rd_values = forwardValues.rd_values;
-        const auto &backward_rf_values = backwardValues.rf_values;
-
-        for (const double bw_rf_value: backward_rf_values)
-            for (const double fw_rd_value: forward_rd_values) {
-                double bw_RC_bound = bw_rf_value + fw_rd_value;
-                if (bw_RC_bound > C && bw_RC_bound < result)
-                    result = bw_RC_bound;
-            }
-    }
+    return result;
+}
 
+template<class state, class action, class environment, MinCriterion criterion, class direction, class priorityQueue>
+template<class pairBound>
+double DBBS<state, action, environment, criterion, direction, priorityQueue>::SmallestBoundAbove(
+        const std::set<double> &xs, const std::set<double> &ys, pairBound bound, double result) const {
+    auto y = ys.end(); // The smallest y whose bound with the current x is above C, end if there is none
+    for (const double x: xs) {
+        while (y != ys.begin() && bound(x, *std::prev(y)) > C)
+            --y;
+        if (y == ys.end())
+            continue;
+        double value = bound(x, *y);
+        if (value < result)
+            result = value;
+    }
     return result;
 }
 
-template<class state, class action, class environment, MinCriterion criterion, class priorityQueue>
-void DBBS<state, action, environment, criterion, priorityQueue>::RunAlgorithm() {
+template<class state, class action, class environment, MinCriterion criterion, class direction, class priorityQueue>
+void DBBS<state, action, environment, criterion, direction, priorityQueue>::RunAlgorithm() {
+    directionPolicy.Reset();
+    sideExpansions[0] = sideExpansions[1] = 0;
     while (!forwardQueue.IsEmpty() && !backwardQueue.IsEmpty()) {
+        if (limiter.Exceeded(nodesExpanded))
+            return;
 
         if (UpdateC()) {
             // TODO think how we are going to parametrize the tie breaker
             if (CheckSolution()) break; // optimality can be proven after updating C
         }
 
-        // TODO: parametrize better whether we want to alternate or to take a look at the open lists
-        if (alternating) { // alternate directions
-            if (expandForward) {
-                ExpandFromBestBucket(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
-                expandForward = false;
-            } else {
-                ExpandFromBestBucket(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
-                expandForward = true;
-            }
-        } else { // choose side with the fewest nodes with minimum g
-
-            double gNodesForward = forwardQueue.getExpandableNodes();
-            double gNodesBackward = backwardQueue.getExpandableNodes();
-
-            if (gNodesForward <= gNodesBackward)
-                ExpandFromBestBucket(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
-            else
-                ExpandFromBestBucket(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
+        if (directionPolicy.ExpandForward(Sides(forwardQueue, backwardQueue, sideExpansions, nodesTouched))) {
+            sideExpansions[0]++;
+            ExpandFromBestBucket(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
+        } else {
+            sideExpansions[1]++;
+            ExpandFromBestBucket(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
         }
 
         if (CheckSolution()) break; // a newer collision after expansion may prove optimality
     }
 }
 
-template<class state, class action, class environment, MinCriterion criterion, class priorityQueue>
-void DBBS<state, action, environment, criterion, priorityQueue>::ExpandFromBestBucket(priorityQueue &current,
+template<class state, class action, class environment, MinCriterion criterion, class direction, class priorityQueue>
+void DBBS<state, action, environment, criterion, direction, priorityQueue>::ExpandFromBestBucket(priorityQueue &current,
                                                                                       priorityQueue &opposite,
                                                                                       Heuristic<state> *heuristic,
                                                                                       Heuristic<state> *reverseHeuristic,
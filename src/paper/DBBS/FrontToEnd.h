@@ -3,6 +3,7 @@
 
 #include "BidirErrorBucketBasedList.h"
 #include "FPUtil.h"
+#include "SearchLimits.h"
 #include <unordered_set>
 #include <unordered_map>
 #include <iostream>
@@ -37,12 +38,18 @@ public:
             return;
 
         RunAlgorithm();
+        if (!limiter.Solved())
+            return;
 
-        if (C > currentCost) {
-            std::cout << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!" << std::endl;
-            exit(0);
-
+        if (currentCost == DBL_MAX) {
+            limiter.Stop(SearchStatus::Unsolvable);
+            return;
+        }
 
+        if (C > currentCost) {
+            std::cerr << "Error: the lower bound " << C << " passed the solution cost " << currentCost << std::endl;
+            limiter.Stop(SearchStatus::Failed);
+            return;
         }
 
         ReconstructSolution(thePath);
@@ -75,8 +82,26 @@ public:
         return necessary;
     }
 
+    /**
+     * Sets the resource budgets used by every following search
+     */
+    void SetLimits(const SearchLimits &limits) { limiter.SetLimits(limits); }
+
+    SearchStatus GetSearchStatus() const { return limiter.GetStatus(); }
+
+    /**
+     * @return The best lower bound proven by the last search, which is the solution cost if it was solved
+     */
+    double GetBestLowerBound() const { return limiter.Solved() ? currentCost : C; }
+
+    /**
+     * @return The cost of the best solution found by the last search, DBL_MAX if none was found
+     */
+    double GetBestUpperBound() const { return currentCost; }
+
     void Reset() {
         currentCost = DBL_MAX;
+        limiter.Start();
         forwardQueue.Reset();
         backwardQueue.Reset();
         ResetNodeCount();
@@ -126,6 +151,8 @@ protected:
 
     double C = 0.0;
 
+    SearchLimiter limiter; // RunAlgorithm should stop as soon as it reports that a limit was exceeded
+
     virtual void RunAlgorithm() = 0;
 
 };
@@ -142,8 +169,10 @@ bool FrontToEnd<state, action, environment, priorityQueue>::InitializeSearch(env
     Reset();
     start = from;
     goal = to;
-    if (start == goal)
+    if (start == goal) {
+        currentCost = 0;
         return false;
+    }
 
     double forwardH = std::max(forwardHeuristic->HCost(start, goal), epsilon);
     double backwardH = std::max(backwardHeuristic->HCost(goal, start), epsilon);
@@ -1,4 +1,9 @@
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#ifdef __linux__
+#include <sched.h>
+#endif
 #include "ArgParameters.h"
 #include "PancakeDriver.h"
 #include "GridDriver.h"
@@ -12,9 +17,59 @@ void printRunLine(int argc, char *argv[]) {
     std::cout << argv[argc - 1] << std::endl;
 }
 
+/**
+ * Restricts the process to the cores [first, first + count), so timings do not suffer from migrations between cores.
+ * Threads started afterwards inherit the restriction.
+ */
+void pinToCores(int first, int count) {
+#ifdef __linux__
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    for (int core = first; core < first + count && core < CPU_SETSIZE; ++core)
+        CPU_SET(core, &cores);
+    if (sched_setaffinity(0, sizeof(cores), &cores) != 0) {
+        std::cerr << "Error: Cannot pin to core " << first << std::endl;
+        exit(EXIT_FAILURE);
+    }
+#else
+    std::cerr << "Warning: --pin-core is only supported on Linux, ignoring it" << std::endl;
+#endif
+}
+
+/**
+ * @return The number of threads a single search of the algorithm runs on
+ */
+int threadsPerSearch(const std::string &alg, const ArgParameters &ap) {
+    if (alg == "BAE-par")
+        return 2;
+    if (alg == "BAE-hd")
+        return 2 * ap.run.searchThreads;
+    return 1;
+}
+
 int main(int argc, char *argv[]) {
     printRunLine(argc, argv);
     ArgParameters ap(argc, argv);
+    if (ap.pinCore >= 0) {
+        // When racing, every algorithm runs on its own thread, and a parallel algorithm on several
+        int searches = ap.race ? static_cast<int>(ap.algs.size()) : ap.threads;
+        int perSearch = 1;
+        for (const auto &alg: ap.algs)
+            perSearch = std::max(perSearch, threadsPerSearch(alg, ap));
+        pinToCores(ap.pinCore, searches * perSearch);
+    }
+
+    CancelToken raceToken;
+    if (ap.race)
+        ap.run.limits.cancel = &raceToken;
+
+    std::unique_ptr<ResultsSink> sink;
+    if (!ap.resultsFile.empty()) {
+        std::string map = ap.map.substr(ap.map.find_last_of("/\\") + 1);
+        sink.reset(new ResultsSink(ap.resultsFile, ap.resultsFormat, ap.domain, ap.heuristic, map));
+        ap.run.sink = sink.get();
+    }
+
     if (ap.domain == "pancake") {
         direction_pancake::testPancake(ap);
     } else if (ap.domain == "grid") {
@@ -2,11 +2,9 @@
 #include "ScenarioLoader.h"
 #include "Map.h"
 #include "Map2DEnvironment.h"
-#include "BAE.h"
-#include "BAEBFD.h"
-#include "DBBS/DBBS.h"
-#include "TwoLevelBAE.h"
-#include "TemplateAStar.h"
+#include "InstanceRunner.h"
+#include "AlgorithmRegistry.h"
+#include <sstream>
 
 
 namespace direction_grid {
@@ -16,18 +14,40 @@ std::string getFileName(const std::string &path) {
     return (pos == std::string::npos) ? path : path.substr(pos + 1);
 }
 
-void testGrid(const ArgParameters &ap) {
-    ScenarioLoader s(ap.scenario.c_str());
-    Map m(ap.map.c_str());
-    MapEnvironment env(&m);
-    env.SetDiagonalCost(1.5);
+/**
+ * Everything a single worker needs to run algorithms on its own. Each worker loads its own copy of the map.
+ */
+struct GridContext {
+    GridContext(const std::string &mapFile, const RunOptions &options)
+            : m(mapFile.c_str()), env(&m), algorithms(1, options) {
+        env.SetDiagonalCost(1.5);
+        AddDirectionAlgorithms(algorithms, 1.0, 0.5);
+        AddDirectIndexAlgorithms(algorithms, 1.0, 0.5);
+    }
 
-    Timer timer;
+    Map m;
+    MapEnvironment env;
     std::vector<xyLoc> solutionPath;
+    Timer timer;
+    AlgorithmRegistry<xyLoc, tDirection, MapEnvironment> algorithms;
+};
+
+struct GridInstance {
+    int id;
     xyLoc start, goal;
+};
+
+void testGrid(const ArgParameters &ap) {
+    ScenarioLoader s(ap.scenario.c_str());
+
+    AlgorithmRegistry<xyLoc, tDirection, MapEnvironment> registry;
+    AddDirectionAlgorithms(registry, 1.0, 0.5);
+    AddDirectIndexAlgorithms(registry, 1.0, 0.5);
+    registry.VerifyAlgorithms(ap.algs);
 
     std::cout << "[D] domain: " << ap.domain << "; map: " << getFileName(ap.map) << std::endl;
     std::set<int> buckets;
+    std::vector<GridInstance> instances;
 
     for (int i: ap.instances) {
         if (i < 0 || i >= s.GetNumExperiments() || s.GetNthExperiment(i).GetDistance() == 0) {
@@ -40,112 +60,29 @@ void testGrid(const ArgParameters &ap) {
             buckets.insert(s.GetNthExperiment(i).GetBucket());
         }
 
-        start.x = s.GetNthExperiment(i).GetStartX();
-        start.y = s.GetNthExperiment(i).GetStartY();
-        goal.x = s.GetNthExperiment(i).GetGoalX();
-        goal.y = s.GetNthExperiment(i).GetGoalY();
-
-        std::cout << "[I] ID: " << i << "; start: " << start << "; goal: " << goal << std::endl;
-
-        if (ap.hasAlgorithm("BAE-a")) {
-            BAE<xyLoc, tDirection, MapEnvironment> bae(true, 1.0, 0.5);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-a; solution: %1.1f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-p")) {
-            BAE<xyLoc, tDirection, MapEnvironment> bae(false, 1.0, 0.5);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-p; solution: %1.1f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-a")) {
-            BAEBFD<xyLoc, tDirection, MapEnvironment> bae(BaeDirStrategy::BFD_Alternating, 1.0, 0.5);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-a; solution: %1.1f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-f")) {
-            BAEBFD<xyLoc, tDirection, MapEnvironment> bae(BaeDirStrategy::BFD_Forward, 1.0, 0.5);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-f; solution: %1.1f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-f")) {
-            BAEBFD<xyLoc, tDirection, MapEnvironment> bae(BaeDirStrategy::BFD_Backward, 1.0, 0.5);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-b; solution: %1.1f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("TLBAE-a")) {
-            TwoLevelBAE<xyLoc, tDirection, MapEnvironment> bae(true, 0.5);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = bae.GetSolLen();
-            printf("[R] alg: TLBAE-a; solution: %1.1f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("TLBAE-p")) {
-            TwoLevelBAE<xyLoc, tDirection, MapEnvironment> bae(false, 0.5);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = bae.GetSolLen();
-            printf("[R] alg: TLBAE-p; solution: %1.1f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("DBBS-a")) {
-            DBBS<xyLoc, tDirection, MapEnvironment, MinCriterion::MinB> dbbs(true, true, 1.0, 0.5);
-            timer.StartTimer();
-            dbbs.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: dbbs-a; solution: %1.1f; expanded: %llu; fabove: 0; time: %1.6fs\n",
-                   solLen, dbbs.GetNodesExpanded(),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("DBBS-p")) {
-            DBBS<xyLoc, tDirection, MapEnvironment, MinCriterion::MinB> dbbs(false, true, 1.0, 0.5);
-            timer.StartTimer();
-            dbbs.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: dbbs-p; solution: %1.1f; expanded: %llu; fabove: 0; time: %1.6fs\n",
-                   solLen, dbbs.GetNodesExpanded(),
-                   timer.GetElapsedTime());
-        }
+        GridInstance instance;
+        instance.id = i;
+        instance.start.x = s.GetNthExperiment(i).GetStartX();
+        instance.start.y = s.GetNthExperiment(i).GetStartY();
+        instance.goal.x = s.GetNthExperiment(i).GetGoalX();
+        instance.goal.y = s.GetNthExperiment(i).GetGoalY();
+        instances.push_back(instance);
     }
+
+    InstanceRunner<GridContext> runner(ap.threads, [&ap]() {
+        return std::unique_ptr<GridContext>(new GridContext(ap.map, ap.run));
+    }, ap.run.limits.cancel);
+    runner.Run(instances.size(), ap.algs,
+               [&](size_t x) {
+                   std::stringstream ss;
+                   ss << "[I] ID: " << instances[x].id << "; start: " << instances[x].start << "; goal: "
+                      << instances[x].goal << std::endl;
+                   return ss.str();
+               },
+               [&](GridContext &ctx, size_t x, const std::string &alg) {
+                   return ctx.algorithms.Run(alg, instances[x].id, ctx.env, instances[x].start, instances[x].goal,
+                                             ctx.solutionPath, ctx.timer);
+               });
 }
 
 }
@@ -0,0 +1,184 @@
+#ifndef SRC_PAPER_INSTANCERUNNER_H
+#define SRC_PAPER_INSTANCERUNNER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SearchLimits.h"
+
+/**
+ * Appends printf-style formatted text to a string. Used instead of printf so that the output of a run can be
+ * collected by a worker thread and printed later in a deterministic order.
+ */
+inline void AppendFormat(std::string &out, const char *format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0)
+        return;
+    if (static_cast<size_t>(len) < sizeof(buffer)) {
+        out.append(buffer, len);
+        return;
+    }
+    std::vector<char> big(len + 1);
+    va_start(args, format);
+    vsnprintf(big.data(), big.size(), format, args);
+    va_end(args);
+    out.append(big.data(), len);
+}
+
+/**
+ * Runs every (instance, algorithm) pair of a sweep. With a single thread everything runs inline in the calling
+ * thread, exactly like a plain nested loop. With more threads, the pairs are farmed out to a pool of workers, each
+ * owning its own context (environment, timer, etc.) created by the given factory.
+ *
+ * In race mode the algorithms of an instance run at once instead, each on its own thread with its own context. The
+ * first one to solve the instance cancels the others through the race token, given to the searches in their limits,
+ * and the block of the instance ends with a [W] line naming it, with the time from the start of the race.
+ *
+ * In all cases the output of an instance is printed as one block: its header line followed by the results of
+ * every algorithm in the order they were given, and instances are printed in the order they were given.
+ *
+ * @tparam context Per-worker data; everything that is not safe to share between threads should live here
+ */
+template<class context>
+class InstanceRunner {
+public:
+    // Returns the [I] line of the instance with the given index
+    using HeaderFn = std::function<std::string(size_t instance)>;
+    // Runs a single algorithm on the instance with the given index and returns its [R] line(s)
+    using TaskFn = std::function<std::string(context &ctx, size_t instance, const std::string &alg)>;
+    using ContextFactory = std::function<std::unique_ptr<context>()>;
+
+    /**
+     * @param race_ If set, the algorithms of every instance race each other, and this is the token they cancel with
+     */
+    InstanceRunner(int threads_, ContextFactory factory_, CancelToken *race_ = nullptr)
+            : threads(std::max(threads_, 1)), factory(factory_), race(race_) {}
+
+    void Run(size_t numInstances, const std::vector<std::string> &algs, HeaderFn header, TaskFn task);
+
+private:
+    void RunSequential(size_t numInstances, const std::vector<std::string> &algs, HeaderFn &header, TaskFn &task);
+
+    void RunParallel(size_t numInstances, const std::vector<std::string> &algs, HeaderFn &header, TaskFn &task);
+
+    void RunRace(size_t numInstances, const std::vector<std::string> &algs, HeaderFn &header, TaskFn &task);
+
+    int threads;
+    ContextFactory factory;
+    CancelToken *race;
+};
+
+template<class context>
+void InstanceRunner<context>::Run(size_t numInstances, const std::vector<std::string> &algs, HeaderFn header,
+                                  TaskFn task) {
+    if (race != nullptr)
+        RunRace(numInstances, algs, header, task);
+    else if (threads == 1 || numInstances * algs.size() <= 1)
+        RunSequential(numInstances, algs, header, task);
+    else
+        RunParallel(numInstances, algs, header, task);
+}
+
+template<class context>
+void InstanceRunner<context>::RunSequential(size_t numInstances, const std::vector<std::string> &algs,
+                                            HeaderFn &header, TaskFn &task) {
+    std::unique_ptr<context> ctx = factory();
+    for (size_t i = 0; i < numInstances; ++i) {
+        std::cout << header(i) << std::flush;
+        for (const auto &alg: algs) {
+            std::cout << task(*ctx, i, alg) << std::flush;
+        }
+    }
+}
+
+template<class context>
+void InstanceRunner<context>::RunParallel(size_t numInstances, const std::vector<std::string> &algs,
+                                          HeaderFn &header, TaskFn &task) {
+    const size_t numTasks = numInstances * algs.size();
+    std::vector<std::string> results(numTasks);
+    std::vector<size_t> remaining(numInstances, algs.size());
+    std::atomic<size_t> nextTask(0);
+    std::mutex lock;
+    std::condition_variable instanceDone;
+
+    // Tasks are handed out in instance-major order, so the instance printed next is always the one being worked on
+    auto worker = [&]() {
+        std::unique_ptr<context> ctx = factory();
+        for (size_t t = nextTask++; t < numTasks; t = nextTask++) {
+            size_t instance = t / algs.size();
+            results[t] = task(*ctx, instance, algs[t % algs.size()]);
+            std::lock_guard<std::mutex> guard(lock);
+            if (--remaining[instance] == 0)
+                instanceDone.notify_one();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i)
+        pool.emplace_back(worker);
+
+    for (size_t i = 0; i < numInstances; ++i) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            instanceDone.wait(guard, [&]() { return remaining[i] == 0; });
+        }
+        std::cout << header(i);
+        for (size_t a = 0; a < algs.size(); ++a) {
+            std::cout << results[i * algs.size() + a];
+            std::string().swap(results[i * algs.size() + a]);
+        }
+        std::cout << std::flush;
+    }
+
+    for (auto &t: pool)
+        t.join();
+}
+
+template<class context>
+void InstanceRunner<context>::RunRace(size_t numInstances, const std::vector<std::string> &algs,
+                                      HeaderFn &header, TaskFn &task) {
+    // Every algorithm keeps its context for the whole sweep, the first one runs on the calling thread
+    std::vector<std::unique_ptr<context>> contexts;
+    for (size_t a = 0; a < algs.size(); ++a)
+        contexts.push_back(factory());
+    std::vector<std::string> results(algs.size());
+
+    for (size_t i = 0; i < numInstances; ++i) {
+        race->Reset();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::thread> racers;
+        for (size_t a = 1; a < algs.size(); ++a)
+            racers.emplace_back([&, a, i]() { results[a] = task(*contexts[a], i, algs[a]); });
+        if (!algs.empty())
+            results[0] = task(*contexts[0], i, algs[0]);
+        for (auto &t: racers)
+            t.join();
+
+        std::string out = header(i);
+        for (auto &result: results)
+            out += result;
+        if (race->Cancelled()) {
+            std::chrono::duration<double> elapsed = race->CancelTime() - start;
+            AppendFormat(out, "[W] winner: %s; time: %1.6fs\n", race->CancelledBy().c_str(), elapsed.count());
+        } else {
+            out += "[W] winner: none\n";
+        }
+        std::cout << out << std::flush;
+    }
+}
+
+#endif //SRC_PAPER_INSTANCERUNNER_H
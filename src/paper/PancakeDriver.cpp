@@ -1,10 +1,9 @@
 #include "PancakeDriver.h"
 #include "PancakePuzzle.h"
 #include "PancakeInstances.h"
-#include "BAE.h"
-#include "BAEBFD.h"
-#include "TwoLevelBAE.h"
-#include "DBBS/DBBS.h"
+#include "InstanceRunner.h"
+#include "AlgorithmRegistry.h"
+#include <sstream>
 
 
 namespace direction_pancake {
@@ -19,122 +18,49 @@ int getGap(const std::string &h) {
 
 }
 
-void testPancake(const ArgParameters &ap) {
-    int gap = getGap(ap.heuristic);
-    printf("[D] domain: pancake; heuristic: GAP-%d\n", gap);
-    PancakePuzzle<N> env(gap);
-    PancakePuzzleState<N> start;
+/**
+ * Everything a single worker needs to run algorithms on its own
+ */
+struct PancakeContext {
+    PancakeContext(int gap, const RunOptions &options) : env(gap), algorithms(0, options) {
+        AddDirectionAlgorithms(algorithms, 1.0, 1.0);
+    }
+
+    PancakePuzzle<N> env;
     PancakePuzzleState<N> goal;
     std::vector<PancakePuzzleState<N>> solutionPath;
     Timer timer;
+    AlgorithmRegistry<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> algorithms;
+};
 
-    for (int i: ap.instances) {
-        if (!GetPancakeInstance(start, i)) {
-            std::cerr << "Error: Invalid Pancake Instance: " << i << std::endl;
-            exit(EXIT_FAILURE);
-        }
-
-        std::cout << "[I] id: " << i << "; instance: " << start << std::endl;
-
-        if (ap.hasAlgorithm("BAE-a")) {
-            BAE<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> bae;
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-a; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-p")) {
-            BAE<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> bae(false);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-p; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-a")) {
-            BAEBFD<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> bae(BaeDirStrategy::BFD_Alternating);
-            timer.StartTimer();
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-a; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-f")) {
-            BAEBFD<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> bae(BaeDirStrategy::BFD_Forward);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-f; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-b")) {
-            BAEBFD<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> bae(BaeDirStrategy::BFD_Backward);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-b; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("TLBAE-a")) {
-            TwoLevelBAE<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> bae;
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = bae.GetSolLen();
-            printf("[R] alg: TLBAE-a; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("TLBAE-p")) {
-            TwoLevelBAE<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> bae(false);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = bae.GetSolLen();
-            printf("[R] alg: TLBAE-p; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
+void testPancake(const ArgParameters &ap) {
+    int gap = getGap(ap.heuristic);
+    AlgorithmRegistry<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>> registry;
+    AddDirectionAlgorithms(registry, 1.0, 1.0);
+    registry.VerifyAlgorithms(ap.algs);
 
-        if (ap.hasAlgorithm("DBBS-a")) {
-            DBBS<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>, MinCriterion::MinB> dbbs(true);
-            timer.StartTimer();
-            dbbs.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: dbbs-a; solution: %1.0f; expanded: %llu; fabove: 0; time: %1.6fs\n",
-                   solLen, dbbs.GetNodesExpanded(),
-                   timer.GetElapsedTime());
-        }
+    printf("[D] domain: pancake; heuristic: GAP-%d\n", gap);
 
-        if (ap.hasAlgorithm("DBBS-p")) {
-            DBBS<PancakePuzzleState<N>, PancakePuzzleAction, PancakePuzzle<N>, MinCriterion::MinB> dbbs(false);
-            timer.StartTimer();
-            dbbs.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: dbbs-p; solution: %1.0f; expanded: %llu; fabove: 0; time: %1.6fs\n",
-                   solLen, dbbs.GetNodesExpanded(),
-                   timer.GetElapsedTime());
+    std::vector<PancakePuzzleState<N>> starts(ap.instances.size());
+    for (size_t x = 0; x < ap.instances.size(); ++x) {
+        if (!GetPancakeInstance(starts[x], ap.instances[x])) {
+            std::cerr << "Error: Invalid Pancake Instance: " << ap.instances[x] << std::endl;
+            exit(EXIT_FAILURE);
         }
     }
+
+    InstanceRunner<PancakeContext> runner(ap.threads, [gap, &ap]() {
+        return std::unique_ptr<PancakeContext>(new PancakeContext(gap, ap.run));
+    }, ap.run.limits.cancel);
+    runner.Run(starts.size(), ap.algs,
+               [&](size_t x) {
+                   std::stringstream ss;
+                   ss << "[I] id: " << ap.instances[x] << "; instance: " << starts[x] << std::endl;
+                   return ss.str();
+               },
+               [&](PancakeContext &ctx, size_t x, const std::string &alg) {
+                   return ctx.algorithms.Run(alg, ap.instances[x], ctx.env, starts[x], ctx.goal, ctx.solutionPath,
+                                             ctx.timer);
+               });
 }
 }
@@ -0,0 +1,292 @@
+#ifndef SRC_PAPER_RESULTSSINK_H
+#define SRC_PAPER_RESULTSSINK_H
+
+#include <atomic>
+#include <cfloat>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "SearchLimits.h"
+#include "InstanceRunner.h"
+
+/**
+ * Everything known about a single (instance, algorithm) run
+ */
+struct RunRecord {
+    int id = 0;
+    std::string alg;
+    SearchStatus status = SearchStatus::Solved;
+    double solution = -1; // -1 if the run was not solved
+    double lowerBound = 0;
+    double upperBound = DBL_MAX; // DBL_MAX if no solution was found
+    uint64_t expanded = 0, unique = 0, touched = 0, necessary = 0;
+    int64_t fAbove = 0;
+    int runs = 1;
+    double time = 0; // Median over all the timed repetitions
+    double timeMin = 0, timeMean = 0, timeStdev = 0;
+    std::string counters; // "key: value; " counters of the algorithm's direction policy, only in the [R] line
+};
+
+/**
+ * The fixed-width record of the binary format. A binary file starts with the 8 bytes of kBinaryMagic, followed by a
+ * uint32_t length and that many bytes of "domain=...;heuristic=...;map=..." text, followed by the records.
+ */
+struct BinaryRunRecord {
+    char alg[24]; // Null-terminated, truncated if longer
+    int32_t id;
+    int32_t status; // SearchStatus
+    double solution, lowerBound, upperBound;
+    uint64_t expanded, unique, touched, necessary;
+    int64_t fAbove;
+    int32_t runs;
+    int32_t reserved;
+    double time, timeMin, timeMean, timeStdev;
+};
+
+static_assert(sizeof(BinaryRunRecord) == 136, "BinaryRunRecord must have no padding");
+
+const char kBinaryMagic[8] = {'B', 'I', 'H', 'S', 'R', 'E', 'S', '1'};
+
+enum class ResultsFormat {
+    CSV,
+    JSONL,
+    Binary
+};
+
+/**
+ * Writes a record of every run to a file, in addition to the [R] lines. Records are collected in a fixed buffer that
+ * is written out when it fills up, when the sink is closed, and when the process receives SIGINT or SIGTERM, so an
+ * interrupted sweep keeps the runs it finished.
+ *
+ * Write is thread-safe; records are written in the order the runs finish.
+ */
+class ResultsSink {
+public:
+    /**
+     * @param path The file to write, truncated if it exists
+     * @param format_ The format of the file
+     * @param domain, heuristic, map Describe the whole sweep. Written on every row in CSV and JSONL, once in binary.
+     */
+    ResultsSink(const std::string &path, ResultsFormat format_, const std::string &domain_,
+                const std::string &heuristic_, const std::string &map_)
+            : format(format_), domain(domain_), heuristic(heuristic_), map(map_), buffer(kBufferSize) {
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Error: Cannot open results file: " << path << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        WriteHeader();
+        Active() = this;
+        previousInt = signal(SIGINT, OnSignal);
+        previousTerm = signal(SIGTERM, OnSignal);
+    }
+
+    ~ResultsSink() { Close(); }
+
+    ResultsSink(const ResultsSink &) = delete;
+
+    ResultsSink &operator=(const ResultsSink &) = delete;
+
+    /**
+     * Parses the name of a format
+     * @return false if there is no such format
+     */
+    static bool ParseFormat(const std::string &name, ResultsFormat &format) {
+        if (name == "csv")
+            format = ResultsFormat::CSV;
+        else if (name == "jsonl")
+            format = ResultsFormat::JSONL;
+        else if (name == "bin")
+            format = ResultsFormat::Binary;
+        else
+            return false;
+        return true;
+    }
+
+    /**
+     * @return The format matching the extension of the given path, CSV if there is no known extension
+     */
+    static ResultsFormat FormatOfPath(const std::string &path) {
+        size_t dot = path.find_last_of('.');
+        ResultsFormat format = ResultsFormat::CSV;
+        if (dot != std::string::npos && ParseFormat(path.substr(dot + 1), format))
+            return format;
+        return ResultsFormat::CSV;
+    }
+
+    void Write(const RunRecord &record) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (format == ResultsFormat::Binary) {
+            BinaryRunRecord bin = ToBinary(record);
+            Append(reinterpret_cast<const char *>(&bin), sizeof(bin));
+            return;
+        }
+        std::string row;
+        if (format == ResultsFormat::CSV)
+            FormatCSV(record, row);
+        else
+            FormatJSONL(record, row);
+        Append(row.data(), row.size());
+    }
+
+    /**
+     * Writes out everything buffered so far and stops listening to signals
+     */
+    void Close() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (fd < 0)
+            return;
+        Flush();
+        if (Active() == this) {
+            signal(SIGINT, previousInt);
+            signal(SIGTERM, previousTerm);
+            Active() = nullptr;
+        }
+        close(fd);
+        fd = -1;
+    }
+
+private:
+    static const size_t kBufferSize = 1 << 20;
+
+    using SignalHandler = void (*)(int);
+
+    static std::atomic<ResultsSink *> &Active() {
+        static std::atomic<ResultsSink *> active(nullptr);
+        return active;
+    }
+
+    // Only uses write and the committed part of the buffer, both safe to touch inside a signal handler
+    static void OnSignal(int sig) {
+        ResultsSink *sink = Active().load();
+        if (sink != nullptr && !sink->flushing.load())
+            WriteAll(sink->fd, sink->buffer.data(), sink->committed.load());
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+
+    static void WriteAll(int fd, const char *data, size_t size) {
+        while (size > 0) {
+            ssize_t written = write(fd, data, size);
+            if (written <= 0)
+                return;
+            data += written;
+            size -= written;
+        }
+    }
+
+    void Append(const char *data, size_t size) {
+        if (committed.load() + size > buffer.size()) {
+            Flush();
+            if (size > buffer.size()) {
+                WriteAll(fd, data, size);
+                return;
+            }
+        }
+        size_t end = committed.load();
+        memcpy(buffer.data() + end, data, size);
+        committed.store(end + size);
+    }
+
+    void Flush() {
+        flushing.store(true);
+        WriteAll(fd, buffer.data(), committed.load());
+        committed.store(0);
+        flushing.store(false);
+    }
+
+    void WriteHeader() {
+        std::string header;
+        switch (format) {
+            case ResultsFormat::CSV:
+                header = "domain,heuristic,map,id,alg,status,solution,expanded,unique,touched,necessary,fabove,lb,ub,"
+                         "runs,time,tmin,tmean,tstdev\n";
+                break;
+            case ResultsFormat::JSONL:
+                break;
+            case ResultsFormat::Binary: {
+                std::string text = "domain=" + domain + ";heuristic=" + heuristic + ";map=" + map;
+                uint32_t length = static_cast<uint32_t>(text.size());
+                header.append(kBinaryMagic, sizeof(kBinaryMagic));
+                header.append(reinterpret_cast<const char *>(&length), sizeof(length));
+                header.append(text);
+                break;
+            }
+        }
+        WriteAll(fd, header.data(), header.size());
+    }
+
+    static void AppendNumber(std::string &out, double value, bool json) {
+        if (value == DBL_MAX)
+            out += json ? "null" : "inf";
+        else
+            AppendFormat(out, "%.10g", value);
+    }
+
+    void FormatCSV(const RunRecord &r, std::string &out) const {
+        out += domain + "," + heuristic + "," + map + ",";
+        AppendFormat(out, "%d,%s,%s,", r.id, r.alg.c_str(), SearchStatusName(r.status));
+        AppendNumber(out, r.solution, false);
+        AppendFormat(out, ",%llu,%llu,%llu,%llu,%lld,", (unsigned long long) r.expanded,
+                     (unsigned long long) r.unique, (unsigned long long) r.touched,
+                     (unsigned long long) r.necessary, (long long) r.fAbove);
+        AppendNumber(out, r.lowerBound, false);
+        out += ",";
+        AppendNumber(out, r.upperBound, false);
+        AppendFormat(out, ",%d,%.6f,%.6f,%.6f,%.6f\n", r.runs, r.time, r.timeMin, r.timeMean, r.timeStdev);
+    }
+
+    void FormatJSONL(const RunRecord &r, std::string &out) const {
+        out += "{\"domain\":\"" + domain + "\",\"heuristic\":\"" + heuristic + "\",\"map\":\"" + map + "\",";
+        AppendFormat(out, "\"id\":%d,\"alg\":\"%s\",\"status\":\"%s\",\"solution\":", r.id, r.alg.c_str(),
+                     SearchStatusName(r.status));
+        AppendNumber(out, r.solution, true);
+        AppendFormat(out, ",\"expanded\":%llu,\"unique\":%llu,\"touched\":%llu,\"necessary\":%llu,\"fabove\":%lld,"
+                          "\"lb\":", (unsigned long long) r.expanded, (unsigned long long) r.unique,
+                     (unsigned long long) r.touched, (unsigned long long) r.necessary, (long long) r.fAbove);
+        AppendNumber(out, r.lowerBound, true);
+        out += ",\"ub\":";
+        AppendNumber(out, r.upperBound, true);
+        AppendFormat(out, ",\"runs\":%d,\"time\":%.6f,\"tmin\":%.6f,\"tmean\":%.6f,\"tstdev\":%.6f}\n", r.runs,
+                     r.time, r.timeMin, r.timeMean, r.timeStdev);
+    }
+
+    static BinaryRunRecord ToBinary(const RunRecord &r) {
+        BinaryRunRecord bin;
+        memset(&bin, 0, sizeof(bin));
+        strncpy(bin.alg, r.alg.c_str(), sizeof(bin.alg) - 1);
+        bin.id = r.id;
+        bin.status = static_cast<int32_t>(r.status);
+        bin.solution = r.solution;
+        bin.lowerBound = r.lowerBound;
+        bin.upperBound = r.upperBound;
+        bin.expanded = r.expanded;
+        bin.unique = r.unique;
+        bin.touched = r.touched;
+        bin.necessary = r.necessary;
+        bin.fAbove = r.fAbove;
+        bin.runs = r.runs;
+        bin.time = r.time;
+        bin.timeMin = r.timeMin;
+        bin.timeMean = r.timeMean;
+        bin.timeStdev = r.timeStdev;
+        return bin;
+    }
+
+    ResultsFormat format;
+    std::string domain, heuristic, map;
+    int fd = -1;
+    std::vector<char> buffer;
+    std::atomic<size_t> committed{0}; // Bytes of buffer holding complete records
+    std::atomic<bool> flushing{false};
+    std::mutex lock;
+    SignalHandler previousInt = SIG_DFL, previousTerm = SIG_DFL;
+};
+
+#endif //SRC_PAPER_RESULTSSINK_H
@@ -0,0 +1,23 @@
+#ifndef SRC_PAPER_RUNOPTIONS_H
+#define SRC_PAPER_RUNOPTIONS_H
+
+#include "SearchLimits.h"
+
+class ResultsSink;
+
+/**
+ * How every single (instance, algorithm) run of a sweep is executed
+ */
+struct RunOptions {
+    bool reuse = false; // Keep one search object per algorithm instead of building one per run
+    SearchLimits limits; // Resource budgets of a single run
+    int repeat = 1; // Number of timed repetitions of every run
+    int warmup = 0; // Number of untimed repetitions done before the timed ones
+    ResultsSink *sink = nullptr; // Where every run is recorded besides the [R] lines, if anywhere
+    int searchThreads = 2; // Threads per direction of the hash-distributed searches
+
+    // With repetitions, the time of a run is reported as statistics over all of them
+    bool IsBenchmark() const { return repeat > 1 || warmup > 0; }
+};
+
+#endif //SRC_PAPER_RUNOPTIONS_H
@@ -5,123 +5,50 @@
 #include "STPDriver.h"
 #include "MNPuzzle.h"
 #include "STPInstances.h"
-#include "BAE.h"
-#include "BAEBFD.h"
-#include "TwoLevelBAE.h"
-#include "DBBS/MinCriterion.h"
-#include "DBBS/DBBS.h"
+#include "InstanceRunner.h"
+#include "AlgorithmRegistry.h"
+#include <sstream>
 
 namespace direction_stp {
-void testSTP(const ArgParameters &ap) {
-    printf("[D] domain: stp; heuristic: MD\n");
+/**
+ * Everything a single worker needs to run algorithms on its own
+ */
+struct STPContext {
+    explicit STPContext(const RunOptions &options) : algorithms(0, options) {
+        AddDirectionAlgorithms(algorithms, 1.0, 1.0);
+    }
+
+    MNPuzzle<4, 4> env;
     MNPuzzleState<4, 4> goal;
     std::vector<MNPuzzleState<4, 4>> solutionPath;
-    MNPuzzle<4, 4> env;
     Timer timer;
+    AlgorithmRegistry<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> algorithms;
+};
 
-    for (int i: ap.instances) {
-        MNPuzzleState<4, 4> start = STP::GetKorfInstance(i);
-        std::cout << "[I] id: " << i << "; instance: " << start << std::endl;
-
-        if (ap.hasAlgorithm("BAE-a")) {
-            BAE<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> bae;
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-a; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-p")) {
-            BAE<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> bae(false);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-p; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-a")) {
-            BAEBFD<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> bae(BaeDirStrategy::BFD_Alternating);
-            timer.StartTimer();
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-a; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-f")) {
-            BAEBFD<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> bae(BaeDirStrategy::BFD_Forward);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-f; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("BAE-bfd-b")) {
-            BAEBFD<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> bae(BaeDirStrategy::BFD_Backward);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: BAE-bfd-b; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("TLBAE-a")) {
-            TwoLevelBAE<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> bae;
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = bae.GetSolLen();
-            printf("[R] alg: TLBAE-a; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
-
-        if (ap.hasAlgorithm("TLBAE-p")) {
-            TwoLevelBAE<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> bae(false);
-            timer.StartTimer();
-            bae.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = bae.GetSolLen();
-            printf("[R] alg: TLBAE-p; solution: %1.0f; expanded: %llu; fabove: %d; time: %1.6fs\n",
-                   solLen, bae.GetNodesExpanded(), bae.GetNumOfExpandedWithFGreaterC(solLen),
-                   timer.GetElapsedTime());
-        }
+void testSTP(const ArgParameters &ap) {
+    AlgorithmRegistry<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>> registry;
+    AddDirectionAlgorithms(registry, 1.0, 1.0);
+    registry.VerifyAlgorithms(ap.algs);
 
-        if (ap.hasAlgorithm("DBBS-a")) {
-            DBBS<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>, MinCriterion::MinB> dbbs(true);
-            timer.StartTimer();
-            dbbs.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: dbbs-a; solution: %1.0f; expanded: %llu; fabove: 0; time: %1.6fs\n",
-                   solLen, dbbs.GetNodesExpanded(),
-                   timer.GetElapsedTime());
-        }
+    printf("[D] domain: stp; heuristic: MD\n");
 
-        if (ap.hasAlgorithm("DBBS-p")) {
-            DBBS<MNPuzzleState<4, 4>, slideDir, MNPuzzle<4, 4>, MinCriterion::MinB> dbbs(false);
-            timer.StartTimer();
-            dbbs.GetPath(&env, start, goal, &env, &env, solutionPath);
-            timer.EndTimer();
-            double solLen = env.GetPathLength(solutionPath);
-            printf("[R] alg: dbbs-p; solution: %1.0f; expanded: %llu; fabove: 0; time: %1.6fs\n",
-                   solLen, dbbs.GetNodesExpanded(),
-                   timer.GetElapsedTime());
-        }
+    std::vector<MNPuzzleState<4, 4>> starts;
+    for (int i: ap.instances) {
+        starts.push_back(STP::GetKorfInstance(i));
     }
+
+    InstanceRunner<STPContext> runner(ap.threads, [&ap]() {
+        return std::unique_ptr<STPContext>(new STPContext(ap.run));
+    }, ap.run.limits.cancel);
+    runner.Run(starts.size(), ap.algs,
+               [&](size_t x) {
+                   std::stringstream ss;
+                   ss << "[I] id: " << ap.instances[x] << "; instance: " << starts[x] << std::endl;
+                   return ss.str();
+               },
+               [&](STPContext &ctx, size_t x, const std::string &alg) {
+                   return ctx.algorithms.Run(alg, ap.instances[x], ctx.env, starts[x], ctx.goal, ctx.solutionPath,
+                                             ctx.timer);
+               });
 }
 }
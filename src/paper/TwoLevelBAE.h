@@ -4,26 +4,19 @@
 #include <cmath>
 #include <iostream>
 #include "BDOpenClosedBAE.h"
+#include "BoundStatistics.h"
+#include "DirectionPolicy.h"
 #include "FPUtil.h"
 #include "Heuristic.h"
+#include "SearchLimits.h"
 
 // Comparators which return true if i2 is preferred over i1
 
 template<class state>
-struct BTLFCompare { // B-comparator
-    bool operator()(const BDOpenClosedBAEData<state> &i1, const BDOpenClosedBAEData<state> &i2) const {
-        double p1 = i1.g + i1.h;
-        double p2 = i2.g + i2.h;
-        if (fequal(p1, p2)) {
-            return (fless(i1.g, i2.g)); // high g-cost over low
-        }
-        return (fgreater(p1, p2)); // low priority over high
-    }
-};
-
-template<class state>
-struct BTLBCompare { // F-comparator
-    bool operator()(const BDOpenClosedBAEData<state> &i1, const BDOpenClosedBAEData<state> &i2) const {
+struct BTLBCompare { // B-comparator of the ready queue, the waiting nodes are kept in layers of equal f
+    // Reads the costs of the nodes, which are either BDOpenClosedBAEData records or the keys of BDCompactStorage
+    template<class node>
+    bool operator()(const node &i1, const node &i2) const {
         double p1 = 2 * i1.g + i1.h - i1.rh;
         double p2 = 2 * i2.g + i2.h - i2.rh;
         if (fequal(p1, p2)) {
@@ -33,24 +26,41 @@ struct BTLBCompare { // F-comparator
     }
 };
 
-template<class state, class action, class environment>
+template<class state, class action, class environment, class statistics = BoundHistogram,
+        class direction = AlternatingDirection, class fStatistics = FCostHistogram,
+        class nodeStorage = BDRecordStorage<state>>
 class TwoLevelBAE {
 public:
-    TwoLevelBAE(bool alternating_ = true, double gcd_ = 1.0) {
+    /**
+     * The side-choosing policy is the direction template parameter, see DirectionPolicy.h. The nodes are kept by
+     * nodeStorage, see BDOpenClosedBAE.h. The expansions per lower bound are counted by statistics, see
+     * BoundStatistics.h
+     * @param gcd_ Greatest common denominator between all edges
+     */
+    TwoLevelBAE(double gcd_ = 1.0) {
         forwardHeuristic = 0;
         backwardHeuristic = 0;
         env = 0;
         gcd = gcd_;
-        alternating = alternating_;
+        forwardQueue.SetIndex(&nodeIndex, 0);
+        backwardQueue.SetIndex(&nodeIndex, 1);
+        forwardQueue.SetGranularity(gcd);
+        backwardQueue.SetGranularity(gcd);
         Reset();
     }
 
     ~TwoLevelBAE() {}
 
-    void ResetNodeCount() { nodesExpanded = nodesTouched = uniqueNodesExpanded = 0; }
+    void ResetNodeCount() {
+        nodesExpanded = nodesTouched = uniqueNodesExpanded = 0;
+        sideExpansions[0] = sideExpansions[1] = 0;
+        boundStatistics.Reset(gcd);
+    }
 
     void Reset() {
         ResetNodeCount();
+        fCostStatistics.Reset();
+        nodeIndex.Reset();
         forwardQueue.Reset(0);
         backwardQueue.Reset(0);
     }
@@ -72,28 +82,93 @@ public:
         return uniqueNodesExpanded;
     }
 
+    uint64_t GetNodesTouched() {
+        return nodesTouched;
+    }
+
+    /**
+     * @return The number of expansions done while the lower bound was below the solution cost, 0 if the statistics
+     * are disabled
+     */
+    uint64_t GetNecessaryExpansions() const { return boundStatistics.CountBelow(currentCost); }
+
+    /**
+     * @return The number of closed nodes with f-cost above cstar. Read from the f-cost statistics if they are recorded,
+     * otherwise counted by scanning both closed lists.
+     */
     int GetNumOfExpandedWithFGreaterC(float cstar);
 
+    /**
+     * Sets the resource budgets used by every following search
+     */
+    void SetLimits(const SearchLimits &limits) { limiter.SetLimits(limits); }
+
+    SearchStatus GetSearchStatus() const { return limiter.GetStatus(); }
+
+    /**
+     * @return The best lower bound proven by the last search, which is the solution cost if it was solved
+     */
+    double GetBestLowerBound() const { return limiter.Solved() ? currentCost : cLowerBound; }
+
+    /**
+     * @return The cost of the best solution found by the last search, DBL_MAX if none was found
+     */
+    double GetBestUpperBound() const { return currentCost; }
+
+    const direction &GetDirectionPolicy() const { return directionPolicy; }
+
 private:
+    typedef BDOpenClosedBAE<state, BTLBCompare<state>, nodeStorage> openClosed;
+
+    /**
+     * The view of the two sides given to the direction policy. The next node of a side is the top of its ready queue.
+     */
+    class Sides {
+    public:
+        explicit Sides(const TwoLevelBAE &search_) : search(search_) {}
+
+        size_t OpenSize(bool forward) const { return Queue(forward).OpenSize(); }
+
+        double TopB(bool forward) const {
+            return Empty(forward) ? DBL_MAX : 2 * Top(forward).g + Top(forward).h - Top(forward).rh;
+        }
+
+        double TopF(bool forward) const { return Empty(forward) ? DBL_MAX : Top(forward).g + Top(forward).h; }
+
+        double TopG(bool forward) const { return Empty(forward) ? DBL_MAX : Top(forward).g; }
+
+        uint64_t Expansions(bool forward) const { return search.sideExpansions[forward ? 0 : 1]; }
+
+        uint64_t Generated() const { return search.nodesTouched; }
+
+    private:
+        const openClosed &Queue(bool forward) const { return forward ? search.forwardQueue : search.backwardQueue; }
+
+        bool Empty(bool forward) const { return Queue(forward).OpenReadySize() == 0; }
+
+        const typename nodeStorage::keys &Top(bool forward) const { return Queue(forward).PeekAt(); }
+
+        const TwoLevelBAE &search;
+    };
+
     double GetCurrentBBound();
 
     void UpdateReadyQueue();
 
-    void Expand(BDOpenClosedBAE<state, BTLBCompare<state>, BTLFCompare<state>> &current,
-                BDOpenClosedBAE<state, BTLBCompare<state>, BTLFCompare<state>> &opposite,
+    void Expand(openClosed &current, openClosed &opposite,
                 Heuristic<state> *heuristic, Heuristic<state> *revHeuristic, const state &target, const state &source);
 
     uint64_t nodesTouched, nodesExpanded, uniqueNodesExpanded;
     state goal, start;
 
-    BDOpenClosedBAE<state, BTLBCompare<state>, BTLFCompare<state>> forwardQueue;
-    BDOpenClosedBAE<state, BTLBCompare<state>, BTLFCompare<state>> backwardQueue;
+    BDSharedIndex nodeIndex; // Finds the records of a state in both directions with a single probe
+    openClosed forwardQueue;
+    openClosed backwardQueue;
 
     Heuristic<state> *forwardHeuristic;
     Heuristic<state> *backwardHeuristic;
     environment *env;
 
-    bool alternating;
     double gcd;
 
     double cLowerBound;
@@ -102,21 +177,39 @@ private:
 
     state middleNode;
 
-    bool expandForward;
+    direction directionPolicy; // Chooses the side of every expansion
+    uint64_t sideExpansions[2]; // Number of expansions on the forward and backward sides
+
+    std::vector<state> neighbors;
+    state expanded; // The state of the node being expanded
+
+    statistics boundStatistics; // Number of expansions done at every value of cLowerBound
+    fStatistics fCostStatistics; // Number of closed nodes at every f-cost
+
+    SearchLimiter limiter;
 };
 
-template<class state, class action, class environment>
-int TwoLevelBAE<state, action, environment>::GetNumOfExpandedWithFGreaterC(float cstar) {
+template<class state, class action, class environment, class statistics, class direction, class fStatistics,
+        class nodeStorage>
+int
+TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage>::GetNumOfExpandedWithFGreaterC(float cstar) {
+    if (fStatistics::kEnabled)
+        return fCostStatistics.CountAbove(cstar);
     int count = 0;
+    state s;
     for (int i = 0; i < forwardQueue.size(); ++i) {
-        auto &n = forwardQueue.Lookup(i);
-        if (n.where == kClosed && n.g + forwardHeuristic->HCost(n.data, goal) > cstar) {
+        if (forwardQueue.Where(i) != kClosed)
+            continue;
+        forwardQueue.GetState(i, s);
+        if (forwardQueue.G(i) + forwardHeuristic->HCost(s, goal) > cstar) {
             count++;
         }
     }
     for (int i = 0; i < backwardQueue.size(); ++i) {
-        auto &n = backwardQueue.Lookup(i);
-        if (n.where == kClosed && n.g + backwardHeuristic->HCost(n.data, start) > cstar) {
+        if (backwardQueue.Where(i) != kClosed)
+            continue;
+        backwardQueue.GetState(i, s);
+        if (backwardQueue.G(i) + backwardHeuristic->HCost(s, start) > cstar) {
             count++;
         }
     }
@@ -124,8 +217,9 @@ int TwoLevelBAE<state, action, environment>::GetNumOfExpandedWithFGreaterC(float
 }
 
 
-template<class state, class action, class environment>
-void TwoLevelBAE<state, action, environment>::GetPath(environment *env_, const state &from, const state &to,
+template<class state, class action, class environment, class statistics, class direction, class fStatistics,
+        class nodeStorage>
+void TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage>::GetPath(environment *env_, const state &from, const state &to,
                                                       Heuristic<state> *forward, Heuristic<state> *backward,
                                                       std::vector<state> &thePath) {
     Reset();
@@ -135,10 +229,13 @@ void TwoLevelBAE<state, action, environment>::GetPath(environment *env_, const s
     thePath.resize(0);
     start = from;
     goal = to;
-    expandForward = true;
+    directionPolicy.Reset();
     currentCost = DBL_MAX;
-    if (start == goal)
+    limiter.Start();
+    if (start == goal) {
+        currentCost = 0;
         return;
+    }
 
     forwardQueue.AddOpenNode(start, env->GetStateHash(start), 0, forwardHeuristic->HCost(start, goal), 0, kTBDNoNode,
                              kOpenReady);
@@ -149,8 +246,10 @@ void TwoLevelBAE<state, action, environment>::GetPath(environment *env_, const s
     while (!DoSingleSearchStep(thePath)) {}
 }
 
-template<class state, class action, class environment>
-bool TwoLevelBAE<state, action, environment>::DoSingleSearchStep(std::vector<state> &thePath) {
+template<class state, class action, class environment, class statistics, class direction, class fStatistics,
+        class nodeStorage>
+bool
+TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage>::DoSingleSearchStep(std::vector<state> &thePath) {
     UpdateReadyQueue();
 
     if (currentCost <= cLowerBound) {
@@ -158,19 +257,18 @@ bool TwoLevelBAE<state, action, environment>::DoSingleSearchStep(std::vector<sta
         return true;
     }
 
-    if (alternating) {
-        if (expandForward) {
-            Expand(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
-            expandForward = false;
-        } else {
-            Expand(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
-            expandForward = true;
-        }
+    if (forwardQueue.OpenSize() == 0 || backwardQueue.OpenSize() == 0)
+        return limiter.Stop(SearchStatus::Unsolvable);
+
+    if (limiter.Exceeded(nodesExpanded))
+        return true;
+
+    if (directionPolicy.ExpandForward(Sides(*this))) {
+        sideExpansions[0]++;
+        Expand(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
     } else {
-        if (forwardQueue.OpenSize() > backwardQueue.OpenSize())
-            Expand(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
-        else
-            Expand(forwardQueue, backwardQueue, forwardHeuristic, backwardHeuristic, goal, start);
+        sideExpansions[1]++;
+        Expand(backwardQueue, forwardQueue, backwardHeuristic, forwardHeuristic, start, goal);
     }
 
     // If the solution lead to emptying one of the Open, which will lead to an infinite loop.
@@ -181,49 +279,36 @@ bool TwoLevelBAE<state, action, environment>::DoSingleSearchStep(std::vector<sta
     return false;
 }
 
-template<class state, class action, class environment>
-double TwoLevelBAE<state, action, environment>::GetCurrentBBound() {
+template<class state, class action, class environment, class statistics, class direction, class fStatistics,
+        class nodeStorage>
+double TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage>::GetCurrentBBound() {
     if (forwardQueue.OpenReadySize() == 0 || backwardQueue.OpenReadySize() == 0) {
         return DBL_MAX;
     }
-    auto &n1 = forwardQueue.Lookup(forwardQueue.Peek(kOpenReady));
-    auto &n2 = backwardQueue.Lookup(backwardQueue.Peek(kOpenReady));
+    auto &n1 = forwardQueue.PeekAt();
+    auto &n2 = backwardQueue.PeekAt();
     double lb = ((2 * n1.g + n1.h - n1.rh) + (2 * n2.g + n2.h - n2.rh)) / 2;
     return ceil(lb / gcd) * gcd;
 }
 
-template<class state, class action, class environment>
-void TwoLevelBAE<state, action, environment>::UpdateReadyQueue() {
-    auto ff = forwardQueue.OpenWaitingSize() == 0 ? DBL_MAX :
-              forwardQueue.Lookup(forwardQueue.Peek(kOpenWaiting)).g +
-              forwardQueue.Lookup(forwardQueue.Peek(kOpenWaiting)).h;
-    auto fb = backwardQueue.OpenWaitingSize() == 0 ? DBL_MAX :
-              backwardQueue.Lookup(backwardQueue.Peek(kOpenWaiting)).g +
-              backwardQueue.Lookup(backwardQueue.Peek(kOpenWaiting)).h;
+template<class state, class action, class environment, class statistics, class direction, class fStatistics,
+        class nodeStorage>
+void TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage>::UpdateReadyQueue() {
+    double ff = forwardQueue.WaitingMinF();
+    double fb = backwardQueue.WaitingMinF();
     double minf = min(ff, fb);
     while (minf <= GetCurrentBBound()) {
         cLowerBound = minf;
 
-        // Move nextF layer into ready
-        while (forwardQueue.OpenWaitingSize() > 0 && forwardQueue.Lookup(forwardQueue.Peek(kOpenWaiting)).g +
-                                                     forwardQueue.Lookup(forwardQueue.Peek(kOpenWaiting)).h ==
-                                                     cLowerBound) {
-            forwardQueue.PutToReady();
-        }
-
-        while (backwardQueue.OpenWaitingSize() > 0 && backwardQueue.Lookup(backwardQueue.Peek(kOpenWaiting)).g +
-                                                      backwardQueue.Lookup(backwardQueue.Peek(kOpenWaiting)).h ==
-                                                      cLowerBound) {
-            backwardQueue.PutToReady();
-        }
+        // Move nextF layer into ready, as a whole
+        if (ff == cLowerBound)
+            forwardQueue.PutLayerToReady();
+        if (fb == cLowerBound)
+            backwardQueue.PutLayerToReady();
 
         // Check next f value
-        ff = forwardQueue.OpenWaitingSize() == 0 ? DBL_MAX :
-             forwardQueue.Lookup(forwardQueue.Peek(kOpenWaiting)).g +
-             forwardQueue.Lookup(forwardQueue.Peek(kOpenWaiting)).h;
-        fb = backwardQueue.OpenWaitingSize() == 0 ? DBL_MAX :
-             backwardQueue.Lookup(backwardQueue.Peek(kOpenWaiting)).g +
-             backwardQueue.Lookup(backwardQueue.Peek(kOpenWaiting)).h;
+        ff = forwardQueue.WaitingMinF();
+        fb = backwardQueue.WaitingMinF();
         minf = min(ff, fb);
     }
 
@@ -234,100 +319,113 @@ void TwoLevelBAE<state, action, environment>::UpdateReadyQueue() {
     }
 }
 
-template<class state, class action, class environment>
+template<class state, class action, class environment, class statistics, class direction, class fStatistics,
+        class nodeStorage>
 void
-TwoLevelBAE<state, action, environment>::Expand(BDOpenClosedBAE<state, BTLBCompare<state>, BTLFCompare<state>> &current,
-                                                BDOpenClosedBAE<state, BTLBCompare<state>, BTLFCompare<state>> &opposite,
-                                                Heuristic<state> *heuristic, Heuristic<state> *revHeuristic,
+TwoLevelBAE<state, action, environment, statistics, direction, fStatistics, nodeStorage>::Expand(openClosed &current,
+                                                openClosed &opposite, Heuristic<state> *heuristic, Heuristic<state> *revHeuristic,
                                                 const state &target, const state &source) {
     uint64_t nextID = current.Close();
+    if (fStatistics::kEnabled)
+        fCostStatistics.Add(current.G(nextID) + current.H(nextID));
     nodesExpanded++;
+    // cLowerBound only changes in UpdateReadyQueue, so this extends the current run of the histogram
+    if (statistics::kEnabled)
+        boundStatistics.Add(cLowerBound);
 
-    if (current.Lookup(nextID).reopened == false)
+    if (current.Reopened(nextID) == false)
         uniqueNodesExpanded++;
 
-    static std::vector<state> neighbors;
-    env->GetSuccessors(current.Lookup(nextID).data, neighbors);
+    current.GetState(nextID, expanded);
+    env->GetSuccessors(expanded, neighbors);
     for (auto &succ: neighbors) {
         nodesTouched++;
         uint64_t childID;
         uint64_t hash = env->GetStateHash(succ);
-        auto loc = current.Lookup(hash, childID);
-        auto &childData = current.Lookup(childID);
-        auto &parentData = current.Lookup(nextID);
+        // The slot holds the records of the state in both directions, so this is the only probe of the index
+        BDSharedSlot *slot = nodeIndex.Find(hash);
+        auto loc = current.Lookup(slot, childID);
 
-        double edgeCost = env->GCost(parentData.data, succ);
+        double edgeCost = env->GCost(expanded, succ);
 
         // ignore states with greater cost than best solution
-        if (fgreatereq(parentData.g + edgeCost + heuristic->HCost(succ, target), currentCost))
+        if (fgreatereq(current.G(nextID) + edgeCost + heuristic->HCost(succ, target), currentCost))
             continue;
 
         switch (loc) {
             case kClosed: {
                 uint64_t oppositeID;
-                auto oppositeLoc = opposite.Lookup(env->GetStateHash(succ), oppositeID);
-                if (fless(parentData.g + edgeCost, childData.g) && oppositeLoc != kClosed) {
+                auto oppositeLoc = opposite.Lookup(slot, oppositeID);
+                if (fless(current.G(nextID) + edgeCost, current.G(childID)) && oppositeLoc != kClosed) {
                     uint64_t currLoopID = nextID;
                     while (currLoopID != 0) {
                         std::cout << currLoopID << ", ";
-                        currLoopID = current.Lookup(currLoopID).parentID;
+                        currLoopID = current.Parent(currLoopID);
                     }
                     std::cout << std::endl;
                     std::cout << "Non optimal g" << std::endl;
                     std::cerr << "Non optimal g" << std::endl;
-                    current.Lookup(childID).parentID = nextID;
-                    current.Lookup(childID).g = current.Lookup(nextID).g + edgeCost;
-                    double childF = current.Lookup(childID).g + current.Lookup(childID).h;
+                    if (fStatistics::kEnabled)
+                        fCostStatistics.Remove(current.G(childID) + current.H(childID));
+                    current.Parent(childID) = nextID;
+                    current.G(childID) = current.G(nextID) + edgeCost;
+                    double childF = current.G(childID) + current.H(childID);
                     current.Reopen(childID, flesseq(childF, cLowerBound) ? kOpenReady : kOpenWaiting);
                 }
                 break;
             }
             case kOpenReady:
             case kOpenWaiting: {
-                if (fless(current.Lookup(nextID).g + edgeCost, current.Lookup(childID).g)) {
-                    current.Lookup(childID).parentID = nextID;
-                    current.Lookup(childID).g = current.Lookup(nextID).g + edgeCost;
+                if (fless(current.G(nextID) + edgeCost, current.G(childID))) {
+                    current.Parent(childID) = nextID;
+                    current.G(childID) = current.G(nextID) + edgeCost;
                     current.KeyChanged(childID);
                     if (loc == kOpenWaiting) {
-                        if (current.Lookup(current.Peek(kOpenWaiting)).g +
-                            current.Lookup(current.Peek(kOpenWaiting)).h <= cLowerBound) {
-                            current.PutToReady();
+                        // Every other waiting node is above cLowerBound, so only this one may have become ready
+                        if (current.G(childID) + current.H(childID) <= cLowerBound) {
+                            current.PutToReady(childID);
                         }
                     }
                     // We postpone moving the node to Ready to the next cycle. It will happen at the very start of the
                     // cycle, where this is the last step.
                     // Try to find it on the opposite OPEN. If it's there, we got a solution - check if it's better
                     uint64_t oppositeID;
-                    auto oppositeLoc = opposite.Lookup(env->GetStateHash(succ), oppositeID);
+                    auto oppositeLoc = opposite.Lookup(slot, oppositeID);
                     if ((oppositeLoc == kOpenReady || oppositeLoc == kOpenWaiting) &&
-                        fless(current.Lookup(nextID).g + edgeCost + opposite.Lookup(oppositeID).g, currentCost)) {
-                        currentCost = current.Lookup(nextID).g + edgeCost + opposite.Lookup(oppositeID).g;
+                        fless(current.G(nextID) + edgeCost + opposite.G(oppositeID), currentCost)) {
+                        currentCost = current.G(nextID) + edgeCost + opposite.G(oppositeID);
                         middleNode = succ;
                         // Prune the node if it has already been expanded in the opposite direction
                     } else if (oppositeLoc == kClosed) {
+                        // The removed node is marked closed, so it is counted like the expanded ones
                         current.Remove(childID);
+                        if (fStatistics::kEnabled)
+                            fCostStatistics.Add(current.G(childID) + current.H(childID));
                     }
                 }
                 break;
             }
             case kUnseen: {
                 uint64_t oppositeID;
-                auto oppositeLoc = opposite.Lookup(env->GetStateHash(succ), oppositeID);
+                auto oppositeLoc = opposite.Lookup(slot, oppositeID);
                 // Do not expand a node which has already been expanded in the opposite direction
                 if (oppositeLoc == kClosed) {
                     break;
                 }
-                double newNodeF = current.Lookup(nextID).g + edgeCost + heuristic->HCost(succ, target);
+                double newNodeF = current.G(nextID) + edgeCost + heuristic->HCost(succ, target);
                 auto newLoc = flesseq(newNodeF, cLowerBound) ? kOpenReady : kOpenWaiting;
-                current.AddOpenNode(succ, env->GetStateHash(succ),
-                                    current.Lookup(nextID).g + edgeCost,
+                // Only a state that neither direction has seen needs a new slot
+                if (slot == nullptr)
+                    slot = &nodeIndex.Insert(hash);
+                current.AddOpenNode(succ, *slot,
+                                    current.G(nextID) + edgeCost,
                                     heuristic->HCost(succ, target),
                                     revHeuristic->HCost(succ, source),
                                     nextID, newLoc);
 
                 if (oppositeLoc == kOpenReady || oppositeLoc == kOpenWaiting) {
-                    if (fless(current.Lookup(nextID).g + edgeCost + opposite.Lookup(oppositeID).g, currentCost)) {
-                        currentCost = current.Lookup(nextID).g + edgeCost + opposite.Lookup(oppositeID).g;
+                    if (fless(current.G(nextID) + edgeCost + opposite.G(oppositeID), currentCost)) {
+                        currentCost = current.G(nextID) + edgeCost + opposite.G(oppositeID);
                         middleNode = succ;
                     }
                 }
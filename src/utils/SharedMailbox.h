@@ -0,0 +1,160 @@
+//
+//  SharedMailbox.h
+//  hog2
+//
+//  A lock-free multiple-producer single-consumer mailbox of message batches.
+//
+
+#ifndef SHARED_MAILBOX_H
+#define SHARED_MAILBOX_H
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/* SharedMailbox
+ *
+ * Unlike SharedQueue, neither side ever takes a lock. Producers send whole
+ * batches, each pushed onto a stack with a single compare-and-swap, and the
+ * single consumer takes everything sent so far with a single exchange.
+ * Since the consumer always empties the stack, a batch is never popped while
+ * another thread reads it, so there is no ABA problem. Batches are delivered
+ * in the order they were sent by each producer.
+ *
+ * Every producer owns a Pool of batches. Once received, a batch goes back to
+ * the pool of its producer, with its items cleared but their memory kept, so
+ * after the first few batches sending allocates nothing. The pool is itself a
+ * stack pushed by the consumers and emptied at once by its owner.
+ */
+
+template <typename T>
+class SharedMailbox {
+    struct Batch;
+
+public:
+    /**
+     * The batches of a single producer. It owns them, wherever they are, so it must outlive their use by the
+     * mailboxes it sends to.
+     */
+    class Pool {
+    public:
+        Pool() : returned(nullptr) {}
+
+        Pool(const Pool &) = delete;
+
+        Pool &operator=(const Pool &) = delete;
+
+    private:
+        friend class SharedMailbox;
+
+        /**
+         * Only called by the owner of the pool
+         * @return An empty batch, allocated only if none was returned
+         */
+        Batch *Take() {
+            if (free.empty()) {
+                for (Batch *batch = returned.exchange(nullptr, std::memory_order_acquire); batch != nullptr;
+                     batch = batch->next)
+                    free.push_back(batch);
+            }
+            if (free.empty()) {
+                all.emplace_back(new Batch);
+                all.back()->pool = this;
+                return all.back().get();
+            }
+            Batch *batch = free.back();
+            free.pop_back();
+            return batch;
+        }
+
+        /**
+         * Safe to call from any thread
+         */
+        void Return(Batch *batch) {
+            batch->items.clear();
+            batch->next = returned.load(std::memory_order_relaxed);
+            while (!returned.compare_exchange_weak(batch->next, batch, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+            }
+        }
+
+        std::vector<std::unique_ptr<Batch>> all; // Every batch of the pool
+        std::vector<Batch *> free; // Batches ready to be sent, only used by the owner
+        std::atomic<Batch *> returned; // Batches received since the owner last took them
+    };
+
+    SharedMailbox() : head(nullptr) {}
+
+    SharedMailbox(const SharedMailbox &) = delete;
+
+    SharedMailbox &operator=(const SharedMailbox &) = delete;
+
+    /**
+     * Sends the items as one batch of the given pool. The items are swapped with the empty items of the batch, so
+     * they are left empty but keep the memory of a batch sent before. Safe to call from any number of threads, each
+     * with its own pool.
+     * @param tag Delivered with the batch, e.g. the index of the sender
+     */
+    void Send(std::vector<T> &items, int tag, Pool &pool) {
+        Batch *batch = pool.Take();
+        batch->items.swap(items);
+        batch->tag = tag;
+        batch->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * Calls receive(items, tag) for every batch sent so far, and returns the batches to their pools. Only the owner
+     * of the mailbox may call it.
+     * @return Whether there was any batch
+     */
+    template <class function>
+    bool Receive(function receive) {
+        Batch *batch = head.exchange(nullptr, std::memory_order_acquire);
+        if (batch == nullptr)
+            return false;
+        // The stack holds the last batch first
+        Batch *ordered = nullptr;
+        while (batch != nullptr) {
+            Batch *next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+        }
+        while (ordered != nullptr) {
+            receive(ordered->items, ordered->tag);
+            Batch *next = ordered->next;
+            ordered->pool->Return(ordered);
+            ordered = next;
+        }
+        return true;
+    }
+
+    bool IsEmpty() const { return head.load(std::memory_order_relaxed) == nullptr; }
+
+    /**
+     * Returns every batch not received yet to its pool. Must not be called while producers send.
+     */
+    void Clear() {
+        Batch *batch = head.exchange(nullptr);
+        while (batch != nullptr) {
+            Batch *next = batch->next;
+            batch->pool->Return(batch);
+            batch = next;
+        }
+    }
+
+private:
+    struct Batch {
+        std::vector<T> items;
+        int tag;
+        Batch *next;
+        Pool *pool; // The pool of the producer, which owns the batch
+    };
+
+    std::atomic<Batch *> head;
+};
+
+#endif